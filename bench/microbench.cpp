@@ -0,0 +1,482 @@
+#include "scan.h"
+#include "literal.h"
+#include "assignment.h"
+#include "formula.h"
+#include "parser.h"
+#include "solver.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace sat
+{
+    struct SolverKernels
+    {
+        using Solver = sat::Solver<DefaultConfig<false, false>>;
+
+        // watches the first two literals of every clause, as solve does
+        static void watch(Solver& solver) { solver.processSingleLiteralClauses(); }
+        static Assignment& assignment(Solver& solver) { return solver.assignment; }
+        static void decide(Solver& solver, const Literal& t) { solver.decide(t); }
+        static void propagate(Solver& solver) { solver.unitPropagation(); }
+        static bool hasConflict(const Solver& solver) { return solver.hasConflict; }
+        static void updateWatches(Solver& solver, const Literal& t) { solver.updateWatches(t); }
+        static void analyzeConflict(Solver& solver) { solver.analyzeConflict(); }
+    };
+}
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+    using Literal = sat::Literal;
+    using Kernels = sat::SolverKernels;
+
+    // keeps benchmarked results alive
+    volatile std::size_t sink;
+
+    // hardware counters of this thread in user space, those the kernel and
+    // the hardware allow; none in most containers and virtual machines
+    class Counters
+    {
+    public:
+        static const int COUNT = 4;
+
+        Counters()
+        {
+            const std::array<std::uint64_t, COUNT> events = {PERF_COUNT_HW_CPU_CYCLES,
+                PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_MISSES};
+            for (int i = 0; i < COUNT; i++) {
+                perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = events[i];
+                attr.disabled = 1;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                fds[i] = static_cast<int>(::syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+            }
+        }
+        ~Counters()
+        {
+            for (int fd: fds) {
+                if (fd >= 0) {
+                    ::close(fd);
+                }
+            }
+        }
+        Counters(const Counters&) = delete;
+        Counters& operator=(const Counters&) = delete;
+
+        bool available(const int i) const { return fds[i] >= 0; }
+        void start()
+        {
+            for (int fd: fds) {
+                if (fd >= 0) {
+                    ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                    ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+                }
+            }
+        }
+        // the counts since start
+        std::array<double, COUNT> stop()
+        {
+            std::array<double, COUNT> counts = {0, 0, 0, 0};
+            for (int i = 0; i < COUNT; i++) {
+                std::uint64_t value = 0;
+                if (fds[i] >= 0) {
+                    ::ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+                    if (::read(fds[i], &value, sizeof(value)) == sizeof(value)) {
+                        counts[i] = static_cast<double>(value);
+                    }
+                }
+            }
+            return counts;
+        }
+
+    private:
+        std::array<int, COUNT> fds;
+    };
+
+    Counters counters;
+
+    // ns per operation over the rounds, and counts per operation
+    struct Stats
+    {
+        double mean = 0;
+        double deviation = 0;
+        double min = 0;
+        std::array<double, Counters::COUNT> counts = {0, 0, 0, 0};
+    };
+
+    // setup runs untimed before every round, run returns the number of
+    // operations it did; the first round only warms up
+    Stats measure(const int rounds, const std::function<void()>& setup,
+            const std::function<std::size_t()>& run)
+    {
+        std::vector<double> samples;
+        Stats stats;
+        for (int r = 0; r <= rounds; r++) {
+            setup();
+            counters.start();
+            const auto start = Clock::now();
+            const std::size_t ops = run();
+            const auto elapsed = Clock::now() - start;
+            const std::array<double, Counters::COUNT> counts = counters.stop();
+            if (r == 0 || ops == 0) {
+                continue;
+            }
+            samples.push_back(std::chrono::duration<double, std::nano>(elapsed).count() / ops);
+            for (int i = 0; i < Counters::COUNT; i++) {
+                stats.counts[i] += counts[i] / ops / rounds;
+            }
+        }
+        for (double s: samples) {
+            stats.mean += s / samples.size();
+        }
+        for (double s: samples) {
+            stats.deviation += (s - stats.mean) * (s - stats.mean) / samples.size();
+        }
+        stats.deviation = std::sqrt(stats.deviation);
+        stats.min = *std::min_element(samples.begin(), samples.end());
+        return stats;
+    }
+
+    void printHeader(const std::string& title, const std::vector<std::string>& parameters)
+    {
+        std::cout << std::endl << title << std::endl;
+        for (const std::string& p: parameters) {
+            std::cout << std::setw(10) << p;
+        }
+        std::cout << std::setw(10) << "ns/op" << std::setw(8) << "+-%" << std::setw(10) << "min"
+                  << std::setw(10) << "cycles" << std::setw(8) << "IPC"
+                  << std::setw(10) << "br-miss" << std::setw(12) << "cache-miss" << std::endl;
+    }
+
+    void printRow(const std::vector<std::size_t>& parameters, const Stats& stats)
+    {
+        for (std::size_t p: parameters) {
+            std::cout << std::setw(10) << p;
+        }
+        std::cout << std::fixed << std::setprecision(2) << std::setw(10) << stats.mean
+                  << std::setprecision(1) << std::setw(8) << 100 * stats.deviation / stats.mean
+                  << std::setprecision(2) << std::setw(10) << stats.min;
+        const int widths[Counters::COUNT] = {10, 8, 10, 12};
+        for (int i = 0; i < Counters::COUNT; i++) {
+            std::cout << std::setw(widths[i]);
+            if (!counters.available(i) || (i == 1 && !counters.available(0))) {
+                std::cout << "n/a";
+            } else if (i == 1) {
+                // instructions per cycle
+                std::cout << stats.counts[1] / std::max(stats.counts[0], 1.0);
+            } else {
+                std::cout << stats.counts[i];
+            }
+        }
+        std::cout << std::endl;
+    }
+
+    // clauses of one length over many variables, every literal false except
+    // one at a random position, so a scan visits half the clause on average
+    struct ScanWorkload
+    {
+        ScanWorkload(const std::size_t length, const int numVars, const std::size_t numClauses):
+            length(length), values(2 * (numVars + 1) + 3, -1)
+        {
+            std::mt19937 rng(42);
+            std::uniform_int_distribution<int> var(1, numVars - 1);
+            std::uniform_int_distribution<std::size_t> pos(0, length - 1);
+            for (std::size_t c = 0; c < numClauses; c++) {
+                const std::size_t target = pos(rng);
+                for (std::size_t i = 0; i < length; i++) {
+                    Literal t(rng() & 1 ? var(rng) : -var(rng));
+                    if (i == target) {
+                        // a true literal, whose complement never occurs
+                        t = Literal(numVars);
+                    }
+                    lits.push_back(t);
+                }
+            }
+            values[Literal(numVars).index()] = 1;
+            values[Literal(-numVars).index()] = -1;
+        }
+
+        std::size_t length;
+        std::vector<Literal> lits;
+        std::vector<signed char> values;
+    };
+
+    double nsPerScan(const ScanWorkload& w, sat::scan::Kernel kernel, const int rounds)
+    {
+        const std::size_t numClauses = w.lits.size() / w.length;
+        std::size_t found = 0;
+        const auto start = Clock::now();
+        for (int r = 0; r < rounds; r++) {
+            for (std::size_t c = 0; c < numClauses; c++) {
+                const std::size_t begin = c * w.length;
+                found += kernel(w.lits.data(), begin, begin + w.length, w.values.data());
+            }
+        }
+        const auto elapsed = Clock::now() - start;
+        sink = found;
+        return std::chrono::duration<double, std::nano>(elapsed).count()
+            / (static_cast<double>(rounds) * numClauses);
+    }
+
+    void benchScan()
+    {
+        std::cout << std::endl << "replacement watch scan, ns per clause" << std::endl;
+        std::cout << std::setw(8) << "length" << std::setw(12) << "scalar"
+                  << std::setw(12) << "avx2" << std::setw(10) << "speedup" << std::endl;
+        for (std::size_t length = 4; length <= 1024; length *= 2) {
+            const ScanWorkload w(length, 1 << 12, (1 << 18) / length);
+            const int rounds = 20;
+            const double scalar = nsPerScan(w, sat::scan::scalar, rounds);
+            std::cout << std::setw(8) << length << std::fixed << std::setprecision(1)
+                      << std::setw(12) << scalar;
+            if (sat::scan::hasAvx2()) {
+                const double avx2 = nsPerScan(w, sat::scan::avx2, rounds);
+                std::cout << std::setw(12) << avx2 << std::setw(9) << scalar / avx2 << "x";
+            } else {
+                std::cout << std::setw(12) << "n/a";
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    // the watch list of literal 1, which becomes false: every clause starts
+    // with it; one in four has its other watch true, the others a single
+    // unassigned literal at a random position among false ones, so the
+    // watch moves there
+    std::unique_ptr<Kernels::Solver> watchWorkload(const std::size_t watches,
+            const std::size_t length, std::mt19937& rng)
+    {
+        const int numVars = static_cast<int>(1 + watches * (length - 1));
+        sat::Formula formula(numVars);
+        std::vector<int> literals;
+        std::vector<int> falsified;
+        std::vector<int> satisfied;
+        std::uniform_int_distribution<std::size_t> pos(2, length - 1);
+        int v = 2;
+        for (std::size_t c = 0; c < watches; c++) {
+            literals.assign(1, 1);
+            for (std::size_t i = 1; i < length; i++) {
+                literals.push_back(v++);
+            }
+            const std::size_t free = pos(rng);
+            for (std::size_t i = 1; i < length; i++) {
+                if (c % 4 == 0 && i == 1) {
+                    satisfied.push_back(literals[i]);
+                } else if (c % 4 != 0 && i != free) {
+                    falsified.push_back(literals[i]);
+                }
+            }
+            formula.addClause(sat::Clause(literals));
+        }
+        auto solver = std::make_unique<Kernels::Solver>(std::move(formula));
+        Kernels::watch(*solver);
+        sat::Assignment& assignment = Kernels::assignment(*solver);
+        for (int x: satisfied) {
+            assignment.set(Literal(x));
+        }
+        for (int x: falsified) {
+            assignment.set(Literal(-x));
+        }
+        Kernels::decide(*solver, Literal(-1));
+        return solver;
+    }
+
+    void benchWatches()
+    {
+        printHeader("updateWatches, ns per watched clause", {"watches", "length"});
+        std::mt19937 rng(42);
+        for (std::size_t length: {4, 16, 64}) {
+            // at most a million literals
+            for (std::size_t watches = 16; watches * length <= (1 << 20); watches *= 16) {
+                std::unique_ptr<Kernels::Solver> solver;
+                const Stats stats = measure(watches < 4096 ? 200 : 15,
+                    [&] { solver = watchWorkload(watches, length, rng); },
+                    [&] {
+                        Kernels::updateWatches(*solver, Literal(1));
+                        return watches;
+                    });
+                printRow({watches, length}, stats);
+            }
+        }
+    }
+
+    // a trail of depth literals at the conflict level: its decision implies
+    // a chain, each link also over one of the lower decisions, ending in a
+    // conflict; analysis resolves along the whole chain
+    std::unique_ptr<Kernels::Solver> conflictWorkload(const int depth, const int levels)
+    {
+        // decisions 1 to levels, chain from levels + 1, the variable
+        // falsifying the last link after
+        const int first = levels + 1;
+        const int last = first + depth - 1;
+        const int end = last + 1;
+        sat::Formula formula(end);
+        for (int x = first + 1; x <= last; x++) {
+            formula.addClause(sat::Clause(std::vector<int>{-(x - 1), x, -(1 + x % levels)}));
+        }
+        formula.addClause(sat::Clause(std::vector<int>{-last, end}));
+        formula.addClause(sat::Clause(std::vector<int>{-last, -end}));
+        auto solver = std::make_unique<Kernels::Solver>(std::move(formula));
+        Kernels::watch(*solver);
+        for (int d = 1; d <= levels; d++) {
+            Kernels::decide(*solver, Literal(d));
+            Kernels::propagate(*solver);
+        }
+        Kernels::decide(*solver, Literal(first));
+        Kernels::propagate(*solver);
+        if (!Kernels::hasConflict(*solver)) {
+            throw std::logic_error("conflict workload without a conflict");
+        }
+        return solver;
+    }
+
+    void benchAnalyze()
+    {
+        printHeader("analyzeConflict, ns per trail literal at the conflict level",
+                {"depth", "levels"});
+        for (int levels: {8, 64}) {
+            for (int depth = 64; depth <= (1 << 15); depth *= 8) {
+                std::unique_ptr<Kernels::Solver> solver;
+                const Stats stats = measure(depth < 4096 ? 100 : 15,
+                    [&] { solver = conflictWorkload(depth, levels); },
+                    [&] {
+                        Kernels::analyzeConflict(*solver);
+                        return static_cast<std::size_t>(depth);
+                    });
+                printRow({static_cast<std::size_t>(depth), static_cast<std::size_t>(levels)},
+                        stats);
+            }
+        }
+    }
+
+    void benchBacktrack()
+    {
+        printHeader("Assignment::backtrackTo level 0, ns per unassigned literal",
+                {"depth", "levels"});
+        std::mt19937 rng(42);
+        for (int depth = 1 << 10; depth <= (1 << 20); depth *= 32) {
+            for (int perLevel: {1, 16}) {
+                sat::Assignment assignment(depth);
+                std::vector<int> vars(depth);
+                for (int v = 1; v <= depth; v++) {
+                    vars[v - 1] = v;
+                }
+                const Stats stats = measure(depth < (1 << 16) ? 100 : 15,
+                    [&] {
+                        // random variables in random polarities, one
+                        // decision every perLevel literals
+                        std::shuffle(vars.begin(), vars.end(), rng);
+                        for (int i = 0; i < depth; i++) {
+                            const Literal t(rng() & 1 ? vars[i] : -vars[i]);
+                            if (i % perLevel == 0) {
+                                assignment.decide(t);
+                            } else {
+                                assignment.assign(t);
+                            }
+                        }
+                    },
+                    [&] {
+                        assignment.backtrackTo(0);
+                        return static_cast<std::size_t>(depth);
+                    });
+                printRow({static_cast<std::size_t>(depth),
+                        static_cast<std::size_t>(depth / perLevel)}, stats);
+            }
+        }
+    }
+
+    // random 3-SAT at the threshold ratio, about bytes long
+    std::size_t writeCnf(const std::string& path, const std::size_t bytes)
+    {
+        std::mt19937 rng(42);
+        const int numVars = std::max<int>(100, static_cast<int>(bytes / 60));
+        std::uniform_int_distribution<int> var(1, numVars);
+        std::size_t numClauses = 0;
+        std::string clauses;
+        while (clauses.size() < bytes) {
+            for (int i = 0; i < 3; i++) {
+                clauses += std::to_string(rng() & 1 ? var(rng) : -var(rng)) + ' ';
+            }
+            clauses += "0\n";
+            numClauses++;
+        }
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << "p cnf " << numVars << ' ' << numClauses << '\n' << clauses;
+        if (!out) {
+            throw std::runtime_error("cannot write " + path);
+        }
+        return numClauses;
+    }
+
+    void benchParse()
+    {
+        printHeader("Parser::getFormula, ns per clause of a random 3-SAT file", {"kbytes", "clauses"});
+        char path[] = "/tmp/microbench-XXXXXX";
+        const int fd = ::mkstemp(path);
+        if (fd < 0) {
+            std::cout << "no temporary file" << std::endl;
+            return;
+        }
+        ::close(fd);
+        for (std::size_t bytes = 1 << 16; bytes <= (1 << 24); bytes *= 16) {
+            const std::size_t numClauses = writeCnf(path, bytes);
+            std::unique_ptr<sat::Parser> parser;
+            const Stats stats = measure(bytes < (1 << 20) ? 50 : 5,
+                [&] { parser = std::make_unique<sat::Parser>(path); },
+                [&] {
+                    sink = parser->getFormula().numClauses();
+                    return numClauses;
+                });
+            printRow({bytes >> 10, numClauses}, stats);
+        }
+        ::unlink(path);
+    }
+}
+
+// runs the kernels named on the command line, or all of them
+int main(int argc, char* argv[])
+{
+    const std::vector<std::pair<std::string, std::function<void()>>> kernels = {
+        {"scan", benchScan}, {"watches", benchWatches}, {"analyze", benchAnalyze},
+        {"backtrack", benchBacktrack}, {"parse", benchParse}};
+    for (int i = 1; i < argc; i++) {
+        if (std::none_of(kernels.begin(), kernels.end(),
+                    [&](const std::pair<std::string, std::function<void()>>& k) {
+                        return k.first == argv[i]; })) {
+            std::cerr << argv[0] << " [scan] [watches] [analyze] [backtrack] [parse]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (!counters.available(0)) {
+        std::cout << "hardware counters not available" << std::endl;
+    }
+    for (const auto& kernel: kernels) {
+        if (argc == 1 || std::any_of(argv + 1, argv + argc,
+                    [&](const char* name) { return kernel.first == name; })) {
+            kernel.second();
+        }
+    }
+    return EXIT_SUCCESS;
+}
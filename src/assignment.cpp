@@ -1,6 +1,7 @@
 
 #include "assignment.h"
 #include <string>
+#include <stdexcept>
 
 using namespace std::string_literals;
 
@@ -9,142 +10,118 @@ sat::Assignment::Assignment(const int numVars): numVars(numVars)
     if (numVars <= 0) {
         throw std::out_of_range("invalid numVars "s + std::to_string(numVars));
     }
+    // padded for the 4 byte gathers of scan::avx2
+    litValues.resize(2 * (numVars + 1) + 3, 0);
+    varLevel.resize(numVars + 1, 0);
+    varPosition.resize(numVars + 1, 0);
+    phases.resize(numVars + 1, 1);
+    trail.reserve(numVars);
 }
 
-int sat::Assignment::total() const
+void sat::Assignment::addVariable()
 {
-    return numVars;
+    numVars++;
+    litValues.resize(2 * (numVars + 1) + 3, 0);
+    varLevel.push_back(0);
+    varPosition.push_back(0);
+    phases.push_back(1);
 }
 
-int sat::Assignment::unassigned() const
+void sat::Assignment::checkRange(const Literal& t) const
 {
-    return numVars - varStack.size();
-}
-
-bool sat::Assignment::allAssigned() const
-{
-    return unassigned() == 0;
-}
-
-bool sat::Assignment::isAssigned(const Literal& t) const
-{
-    if (t.id() <= 0 || t.id() > numVars) {
+    if (!inRange(t)) {
         throw std::out_of_range("invalid var "s + std::to_string(t.id()));
     }
-    if (varMap.find(t.id()) != varMap.end()) {
-        if (varMap.at(t.id()) < varStack.size()
-                && getValue(t.id()).var == t.id()) {
-            return true;
-        } else {
-            varMap.erase(t.id());
-        }
-    }
-    return false;
 }
 
 void sat::Assignment::checkIsAssigned(const Literal& t) const
 {
+    checkRange(t);
     if (!isAssigned(t)) {
         throw std::invalid_argument("var "s + std::to_string(t.id()) + " is not assigned"s);
     }
 }
 
-bool sat::Assignment::isTrue(const Literal& t) const
-{
-    return isAssigned(t) && evaluate(t);
-}
-
-bool sat::Assignment::isFalse(const Literal& t) const
-{
-    return isAssigned(t) && !evaluate(t);
-}
-
 bool sat::Assignment::evaluate(const Literal& t) const
 {
     checkIsAssigned(t);
-    return t.evaluate(getValue(t.id()).value);
-}
-
-const sat::Assignment::Value& sat::Assignment::getValue(const int id) const
-{
-    return varStack.at(varMap.at(id));
+    return isTrue(t);
 }
 
 bool sat::Assignment::isBefore(const sat::Literal& t1, const sat::Literal& t2) const
 {
     checkIsAssigned(t1);
     checkIsAssigned(t2);
-    return t1.id() != t2.id() && varMap.at(t1.id()) < varMap.at(t2.id());
-}
-
-int sat::Assignment::currentLevel() const
-{
-    return varDecisions.size();
+    return precedes(t1, t2);
 }
 
 int sat::Assignment::level(const Literal& t) const
 {
     checkIsAssigned(t);
-    return getValue(t.id()).level;
-}
-
-sat::Literal sat::Assignment::toLiteral(const sat::Assignment::Value& v) const
-{
-    return Literal(v.value ? v.var : -v.var);
+    return levelOf(t);
 }
 
 sat::Literal sat::Assignment::lastDecision() const
 {
-    if (currentLevel() == 0) {
-        throw std::out_of_range("No decision made");
+    for (std::size_t i = levelStart.size(); i-- > 0;) {
+        if (levelStart[i] < trail.size()) {
+            return trail[levelStart[i]];
+        }
     }
-    return toLiteral(getValue(varDecisions.back()));
+    throw std::out_of_range("No decision made");
 }
 
 sat::Literal sat::Assignment::lastAssigned() const
 {
-    if (varStack.empty()) {
+    if (trail.empty()) {
         throw std::out_of_range("No assignment made");
     }
-    return toLiteral(varStack.back());
+    return trail.back();
 }
 
 std::vector<sat::Literal> sat::Assignment::decisions() const
 {
     std::vector<Literal> ret;
-    for (int i: varDecisions) {
-        ret.push_back(toLiteral(getValue(i)));
+    for (std::size_t level = 0; level < levelStart.size(); level++) {
+        // levels without a decision share their start with the next
+        const std::size_t i = levelStart[level];
+        if (i < trail.size() && (level + 1 == levelStart.size() || levelStart[level + 1] > i)) {
+            ret.push_back(trail[i]);
+        }
     }
     return ret;
 }
 
 bool sat::Assignment::isDecided(const Literal& t) const
 {
-    return isAssigned(t) && varDecisions.at(level(t)-1) == t.id();
+    checkRange(t);
+    return isAssigned(t) && levelOf(t) > 0
+        && trail[levelStart[levelOf(t)-1]].id() == t.id();
 }
 
 void sat::Assignment::decide(const Literal& t)
 {
-    // making a decsion, increment decision level
-    varDecisions.push_back(t.id());
-    assign(t);
+    checkRange(t);
+    if (isAssigned(t)) {
+        throw std::invalid_argument("deciding var "s + std::to_string(t.id())
+                                    + " that is already assigned");
+    }
+    setDecision(t);
 }
 
 void sat::Assignment::assign(const Literal& t)
 {
-    if (t.id() <= 0 || t.id() > numVars) {
-        throw std::out_of_range("invalid var "s + std::to_string(t.id()));
-    }
+    checkRange(t);
     if (!isAssigned(t)) {
-        varStack.push_back({t.id(), t.polarity(), currentLevel()});
-        varMap[t.id()] = varStack.size() - 1;
+        set(t);
+    } else if (trail.back().id() == t.id()) {
+        // overwrite the value of the last assigned variable
+        litValues[t.index()] = 1;
+        litValues[t.negate().index()] = -1;
+        trail.back() = t;
     } else {
-        if (varMap.at(t.id()) == varStack.size()-1) {
-            varStack[varStack.size()-1].value = t.polarity();
-        } else {
-            throw std::invalid_argument("reassigning var "s + std::to_string(t.id())
-                                        + " that is not the last assigned");
-        }
+        throw std::invalid_argument("reassigning var "s + std::to_string(t.id())
+                                    + " that is not the last assigned");
     }
 }
 
@@ -155,33 +132,22 @@ void sat::Assignment::backtrackTo(const int level)
     }
     // remove all decisions made after level
     // preserving decisions up to and including level
-    // remove all variable assignments made >= level+1
-    // index = level-1
-    removeVar(varDecisions.at(level));
-    varDecisions.resize(level);
+    cancelUntil(level);
 }
 
 void sat::Assignment::backtrack(const Literal& t)
 {
     checkIsAssigned(t);
-    const int lvl = level(t);
-    removeVar(t.id());
-    // level = vector size
-    varDecisions.resize(lvl);
-}
-
-void sat::Assignment::removeVar(const int varId)
-{
-    varStack.resize(varMap.at(varId));
-    varMap.erase(varId);
+    // removes t, everything assigned after it, and its level if t is a decision
+    truncate(varPosition[t.id()]);
 }
 
 std::vector<bool> sat::Assignment::values() const
 {
     std::vector<bool> ret;
     for (int i = 1; i <= numVars; i++) {
-        const bool val = varStack.at(varMap.at(i)).value;
-        ret.push_back(val);
+        checkIsAssigned(Literal(i));
+        ret.push_back(isTrue(Literal(i)));
     }
     return ret;
 }
@@ -3,8 +3,8 @@
 #define SAT_ASSIGNMENT_H
 
 #include "literal.h"
+#include "debug.h"
 #include <vector>
-#include <unordered_map>
 
 namespace sat
 {
@@ -12,20 +12,45 @@ namespace sat
     class Assignment
     {
     public:
-        Assignment(const int numVars);
-        int unassigned() const;
-        int total() const;
-        bool allAssigned() const;
-
-        bool isAssigned(const Literal& t) const;
-        bool isTrue(const Literal& t) const;
-        bool isFalse(const Literal& t) const;
-        bool evaluate(const Literal& t) const;  // can throw
+        explicit Assignment(const int numVars); // can throw
+        // a fresh unassigned variable numbered after the others
+        void addVariable();
+        int unassigned() const noexcept { return numVars - static_cast<int>(trail.size()); }
+        int total() const noexcept { return numVars; }
+        bool allAssigned() const noexcept { return unassigned() == 0; }
+        int currentLevel() const noexcept { return static_cast<int>(levelStart.size()); }
 
+        // unchecked accessors for the solver core, literals must be in range,
+        // and assigned where a level or an order is asked for;
+        // validated only in DEBUG builds
+        bool isAssigned(const Literal& t) const noexcept;
+        bool isTrue(const Literal& t) const noexcept;
+        bool isFalse(const Literal& t) const noexcept;
+        int levelOf(const Literal& t) const noexcept;
         // if t1 is assigned before t2
-        bool isBefore(const Literal& t1, const Literal& t2) const;
+        bool precedes(const Literal& t1, const Literal& t2) const noexcept;
+        // t must be unassigned
+        void set(const Literal& t) noexcept;
+        void setDecision(const Literal& t) noexcept;
+        // a level without a decision, for an assumption that already holds
+        void newLevel() noexcept { levelStart.push_back(trail.size()); }
+        // t must be assigned
+        bool isDecision(const Literal& t) const noexcept;
+        // level must not be above the current level
+        void cancelUntil(const int level) noexcept;
+        // assigned literals in assignment order
+        const std::vector<Literal>& trailLiterals() const noexcept { return trail; }
+        // trail position after the literals of levels up to level
+        std::size_t levelEnd(const int level) const noexcept;
+        // indexed by Literal::index(): 1 true, -1 false, 0 unassigned
+        const signed char* literalValues() const noexcept { return litValues.data(); }
+        // last value of a variable before it was unassigned, initially true
+        bool savedPhase(const int var) const noexcept { return phases[var] != 0; }
+        void setSavedPhase(const int var, const bool value) noexcept { phases[var] = value; }
 
-        int currentLevel() const;
+        // checked API, validates its arguments
+        bool evaluate(const Literal& t) const;  // can throw
+        bool isBefore(const Literal& t1, const Literal& t2) const; // can throw
         int level(const Literal& t) const; // can throw
         Literal lastDecision() const;
         Literal lastAssigned() const;
@@ -39,24 +64,117 @@ namespace sat
         void backtrack(const Literal& t);
 
         std::vector<bool> values() const;
+        // bytes held by the value arrays and the trail
+        std::size_t memoryUsage() const noexcept;
 
     private:
-        struct Value
-        {
-            int var;
-            bool value;
-            int level;
-        };
+        void checkRange(const Literal& t) const;
         void checkIsAssigned(const Literal& t) const;
-        const Value& getValue(const int id) const;
-        Literal toLiteral(const Value& v) const;
-        void removeVar(const int varId);
-
-        const int numVars;
-        mutable std::unordered_map<int, std::size_t> varMap;
-        std::vector<Value> varStack;
-        std::vector<int> varDecisions;
+        bool inRange(const Literal& t) const noexcept { return t.id() > 0 && t.id() <= numVars; }
+        void truncate(const std::size_t position) noexcept;
+
+        int numVars;
+        // see literalValues()
+        std::vector<signed char> litValues;
+        // indexed by variable
+        std::vector<int> varLevel;
+        std::vector<int> varPosition;
+        std::vector<char> phases;
+        std::vector<Literal> trail;
+        // trail position of the decision of each level, levels without
+        // a decision start at the decision of the next
+        std::vector<std::size_t> levelStart;
     };
+
+    inline bool Assignment::isAssigned(const Literal& t) const noexcept
+    {
+        DBGASSERT(inRange(t), "invalid var " << t.id());
+        return litValues[t.index()] != 0;
+    }
+
+    inline bool Assignment::isTrue(const Literal& t) const noexcept
+    {
+        DBGASSERT(inRange(t), "invalid var " << t.id());
+        return litValues[t.index()] > 0;
+    }
+
+    inline bool Assignment::isFalse(const Literal& t) const noexcept
+    {
+        DBGASSERT(inRange(t), "invalid var " << t.id());
+        return litValues[t.index()] < 0;
+    }
+
+    inline int Assignment::levelOf(const Literal& t) const noexcept
+    {
+        DBGASSERT(isAssigned(t), "var " << t.id() << " is not assigned");
+        return varLevel[t.id()];
+    }
+
+    inline bool Assignment::precedes(const Literal& t1, const Literal& t2) const noexcept
+    {
+        DBGASSERT(isAssigned(t1), "var " << t1.id() << " is not assigned");
+        DBGASSERT(isAssigned(t2), "var " << t2.id() << " is not assigned");
+        return varPosition[t1.id()] < varPosition[t2.id()];
+    }
+
+    inline void Assignment::set(const Literal& t) noexcept
+    {
+        DBGASSERT(!isAssigned(t), "var " << t.id() << " is already assigned");
+        litValues[t.index()] = 1;
+        litValues[t.negate().index()] = -1;
+        varLevel[t.id()] = currentLevel();
+        varPosition[t.id()] = static_cast<int>(trail.size());
+        trail.push_back(t);
+    }
+
+    inline void Assignment::setDecision(const Literal& t) noexcept
+    {
+        // making a decision, increment decision level
+        levelStart.push_back(trail.size());
+        set(t);
+    }
+
+    inline bool Assignment::isDecision(const Literal& t) const noexcept
+    {
+        DBGASSERT(isAssigned(t), "var " << t.id() << " is not assigned");
+        const int level = varLevel[t.id()];
+        return level > 0 && levelStart[level - 1] == static_cast<std::size_t>(varPosition[t.id()]);
+    }
+
+    inline std::size_t Assignment::levelEnd(const int level) const noexcept
+    {
+        DBGASSERT(level >= 0 && level <= currentLevel(), "invalid level " << level);
+        return level < currentLevel() ? levelStart[level] : trail.size();
+    }
+
+    inline void Assignment::cancelUntil(const int level) noexcept
+    {
+        DBGASSERT(level >= 0 && level <= currentLevel(), "invalid target level " << level);
+        if (level < currentLevel()) {
+            truncate(levelStart[level]);
+        }
+    }
+
+    inline std::size_t Assignment::memoryUsage() const noexcept
+    {
+        return litValues.capacity() + phases.capacity()
+            + (varLevel.capacity() + varPosition.capacity()) * sizeof(int)
+            + trail.capacity() * sizeof(Literal) + levelStart.capacity() * sizeof(std::size_t);
+    }
+
+    inline void Assignment::truncate(const std::size_t position) noexcept
+    {
+        while (trail.size() > position) {
+            const Literal& t = trail.back();
+            litValues[t.index()] = 0;
+            litValues[t.negate().index()] = 0;
+            phases[t.id()] = t.polarity();
+            trail.pop_back();
+        }
+        while (!levelStart.empty() && levelStart.back() >= position) {
+            levelStart.pop_back();
+        }
+    }
 }
 
 #endif // SAT_ASSIGNMENT_H
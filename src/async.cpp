@@ -0,0 +1,77 @@
+
+#include "solver.h"
+#include <algorithm>
+
+template <class Config>
+std::future<sat::Outcome> sat::Solver<Config>::solveAsync(const int timeLimitSeconds)
+{
+    return std::async(std::launch::async, [this, timeLimitSeconds] {
+        run(timeLimitSeconds, nullptr);
+        return Outcome{result, model, optimizing ? bestCost : 0, stats};
+    });
+}
+
+template <class Config>
+void sat::Solver<Config>::cancel()
+{
+    budget.stop();
+}
+
+template <class Config>
+void sat::Solver<Config>::setTermination(std::function<bool()> terminate)
+{
+    this->terminate = std::move(terminate);
+}
+
+template <class Config>
+void sat::Solver<Config>::setProgress(std::function<void(const Statistics&)> progress,
+        const std::uint64_t interval)
+{
+    this->progress = std::move(progress);
+    progressInterval = std::max<std::uint64_t>(interval, 1);
+    nextProgress = stats.conflicts + progressInterval;
+}
+
+// the callbacks, at conflicts and between rounds of local search
+template <class Config>
+void sat::Solver<Config>::poll()
+{
+    if (progress && stats.conflicts >= nextProgress) {
+        progress(stats);
+        nextProgress = stats.conflicts + progressInterval;
+    }
+    if (terminate && terminate()) {
+        budget.stop();
+    }
+}
+
+namespace sat
+{
+    template std::future<Outcome> Solver<DefaultConfig<false, false>>::solveAsync(const int);
+    template void Solver<DefaultConfig<false, false>>::cancel();
+    template void Solver<DefaultConfig<false, false>>::setTermination(std::function<bool()>);
+    template void Solver<DefaultConfig<false, false>>::setProgress(std::function<void(const Statistics&)>,
+            const std::uint64_t);
+    template void Solver<DefaultConfig<false, false>>::poll();
+
+    template std::future<Outcome> Solver<DefaultConfig<false, true>>::solveAsync(const int);
+    template void Solver<DefaultConfig<false, true>>::cancel();
+    template void Solver<DefaultConfig<false, true>>::setTermination(std::function<bool()>);
+    template void Solver<DefaultConfig<false, true>>::setProgress(std::function<void(const Statistics&)>,
+            const std::uint64_t);
+    template void Solver<DefaultConfig<false, true>>::poll();
+
+    template std::future<Outcome> Solver<DefaultConfig<true, false>>::solveAsync(const int);
+    template void Solver<DefaultConfig<true, false>>::cancel();
+    template void Solver<DefaultConfig<true, false>>::setTermination(std::function<bool()>);
+    template void Solver<DefaultConfig<true, false>>::setProgress(std::function<void(const Statistics&)>,
+            const std::uint64_t);
+    template void Solver<DefaultConfig<true, false>>::poll();
+
+    template std::future<Outcome> Solver<DefaultConfig<true, true>>::solveAsync(const int);
+    template void Solver<DefaultConfig<true, true>>::cancel();
+    template void Solver<DefaultConfig<true, true>>::setTermination(std::function<bool()>);
+    template void Solver<DefaultConfig<true, true>>::setProgress(std::function<void(const Statistics&)>,
+            const std::uint64_t);
+    template void Solver<DefaultConfig<true, true>>::poll();
+}
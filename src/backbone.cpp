@@ -0,0 +1,98 @@
+
+#include "solver.h"
+#include <algorithm>
+#include <ostream>
+
+template <class Config>
+void sat::Solver<Config>::setBackbone(std::ostream& out)
+{
+    backboneOut = &out;
+}
+
+// the literals of a first model are candidates, each checked by a search
+// assuming its negation: a refutation confirms it, and it is learned as a
+// unit, which may fix others at level 0, and a model drops the candidates
+// it falsifies; learned clauses are kept between the checks
+template <class Config>
+void sat::Solver<Config>::findBackbone()
+{
+    search();
+    backtrack(0);
+    if (result != Result::Satisfiable) {
+        return;
+    }
+    std::vector<bool> found(model);
+    std::vector<Literal> candidates;
+    for (int v = 1; v <= formula.numInputVariables(); v++) {
+        candidates.push_back(Literal(found[v - 1] ? v : -v));
+    }
+    while (!candidates.empty() && !stopped()) {
+        const Literal t = candidates.back();
+        candidates.pop_back();
+        if (assignment.isAssigned(t)) {
+            backbone.push_back(t);
+            continue;
+        }
+        assumptions.assign(1, t.negate());
+        result = Result::Unknown;
+        core.clear();
+        search();
+        backtrack(0);
+        assumptions.clear();
+        if (result == Result::Unsatisfiable) {
+            backbone.push_back(t);
+            addClause({t});
+            unitPropagation();
+        } else if (result == Result::Satisfiable) {
+            found = model;
+            candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                        [&](const Literal& u) { return found[u.id() - 1] != u.polarity(); }),
+                    candidates.end());
+        } else {
+            candidates.push_back(t);
+            break;
+        }
+        // the checks add up to one long search, whose learned clauses would
+        // slow down propagation otherwise
+        if (stats.conflicts - lastReduction >= REDUCE_INTERVAL) {
+            reduceLearnedClauses();
+        }
+    }
+    uncheckedCandidates = candidates.size();
+    result = Result::Satisfiable;
+    model = found;
+    writeBackbone();
+}
+
+template <class Config>
+void sat::Solver<Config>::writeBackbone()
+{
+    std::sort(backbone.begin(), backbone.end(),
+            [](const Literal& t1, const Literal& t2) { return t1.id() < t2.id(); });
+    std::ostream& out = *backboneOut;
+    out << "b ";
+    for (const Literal& t: backbone) {
+        out << t << " ";
+    }
+    out << "0\n";
+    out.flush();
+}
+
+namespace sat
+{
+    template void Solver<DefaultConfig<false, false>>::setBackbone(std::ostream&);
+    template void Solver<DefaultConfig<false, false>>::findBackbone();
+    template void Solver<DefaultConfig<false, false>>::writeBackbone();
+
+    template void Solver<DefaultConfig<false, true>>::setBackbone(std::ostream&);
+    template void Solver<DefaultConfig<false, true>>::findBackbone();
+    template void Solver<DefaultConfig<false, true>>::writeBackbone();
+
+    template void Solver<DefaultConfig<true, false>>::setBackbone(std::ostream&);
+    template void Solver<DefaultConfig<true, false>>::findBackbone();
+    template void Solver<DefaultConfig<true, false>>::writeBackbone();
+
+    template void Solver<DefaultConfig<true, true>>::setBackbone(std::ostream&);
+    template void Solver<DefaultConfig<true, true>>::findBackbone();
+    template void Solver<DefaultConfig<true, true>>::writeBackbone();
+}
@@ -0,0 +1,47 @@
+
+#include "budget.h"
+#include <stdexcept>
+#include <sys/resource.h>
+
+sat::Watchdog::Watchdog(Budget& budget, const std::chrono::nanoseconds& limit):
+    budget(budget)
+{
+    if (limit > std::chrono::nanoseconds(0)) {
+        thread = std::thread(&Watchdog::run, this, std::chrono::steady_clock::now() + limit);
+    }
+}
+
+sat::Watchdog::~Watchdog()
+{
+    if (thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+        }
+        wakeup.notify_one();
+        thread.join();
+    }
+}
+
+void sat::Watchdog::run(const std::chrono::steady_clock::time_point deadline)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!wakeup.wait_until(lock, deadline, [this]() { return done; })) {
+        budget.stop();
+    }
+}
+
+void sat::limitCpuTime(const int seconds)
+{
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_CPU, &limit) != 0) {
+        throw std::runtime_error("Cannot read the cpu time limit");
+    }
+    limit.rlim_cur = seconds;
+    if (limit.rlim_max != RLIM_INFINITY && limit.rlim_max < limit.rlim_cur) {
+        throw std::runtime_error("Cpu time limit above the hard limit");
+    }
+    if (setrlimit(RLIMIT_CPU, &limit) != 0) {
+        throw std::runtime_error("Cannot set the cpu time limit");
+    }
+}
@@ -0,0 +1,75 @@
+
+#ifndef SAT_BUDGET_H
+#define SAT_BUDGET_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+namespace sat
+{
+    static_assert(ATOMIC_BOOL_LOCK_FREE == 2, "stop must be safe in signal handlers");
+
+    // limits of a solve: a stop flag, which watchdogs and signal handlers
+    // may set at any time, and conflict and propagation budgets; checked
+    // by the solver between its steps
+    class Budget
+    {
+    public:
+        // async-signal-safe
+        void stop() noexcept { stopped.store(true, std::memory_order_relaxed); }
+        void setConflicts(const std::uint64_t limit) noexcept { maxConflicts = limit; }
+        void setPropagations(const std::uint64_t limit) noexcept { maxPropagations = limit; }
+        // the budgets count from these numbers on
+        void startAt(const std::uint64_t conflicts, const std::uint64_t propagations) noexcept
+        {
+            maxConflicts = saturatedSum(maxConflicts, conflicts);
+            maxPropagations = saturatedSum(maxPropagations, propagations);
+        }
+        bool exhausted(const std::uint64_t conflicts, const std::uint64_t propagations) const noexcept
+        {
+            return stopped.load(std::memory_order_relaxed)
+                || conflicts >= maxConflicts || propagations >= maxPropagations;
+        }
+
+    private:
+        static std::uint64_t saturatedSum(const std::uint64_t a, const std::uint64_t b) noexcept
+        {
+            return a > std::numeric_limits<std::uint64_t>::max() - b
+                ? std::numeric_limits<std::uint64_t>::max() : a + b;
+        }
+
+        std::atomic<bool> stopped{false};
+        std::uint64_t maxConflicts = std::numeric_limits<std::uint64_t>::max();
+        std::uint64_t maxPropagations = std::numeric_limits<std::uint64_t>::max();
+    };
+
+    // a thread stopping the budget once the wall clock limit has passed,
+    // unless destroyed before; no thread for a limit of zero or less
+    class Watchdog
+    {
+    public:
+        Watchdog(Budget& budget, const std::chrono::nanoseconds& limit);
+        ~Watchdog();
+        Watchdog(const Watchdog&) = delete;
+        Watchdog& operator=(const Watchdog&) = delete;
+
+    private:
+        void run(const std::chrono::steady_clock::time_point deadline);
+
+        Budget& budget;
+        std::mutex mutex;
+        std::condition_variable wakeup;
+        bool done = false;
+        std::thread thread;
+    };
+
+    // the kernel sends SIGXCPU once the process used seconds of cpu time
+    void limitCpuTime(const int seconds); // can throw
+}
+
+#endif // SAT_BUDGET_H
@@ -0,0 +1,320 @@
+
+#include "bva.h"
+#include <algorithm>
+#include <queue>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    const std::uint64_t POLL_STEPS = 1 << 16;
+
+    // clauses as literal indices, removed ones are only flagged; each
+    // literal has the clauses it occurs in, removed ones among them
+    class Reencoder
+    {
+    public:
+        Reencoder(const sat::Formula& formula, const std::uint64_t maxSteps);
+        // returns the number of clauses removed, net
+        int run(const std::function<int()>& newVariable, const std::function<bool()>& stopped);
+        // the clauses of the formula that were replaced
+        bool replaced(const int clause) const { return removed[clause] != 0; }
+        int numClauses() const { return static_cast<int>(clauses.size()); }
+        const std::vector<int>& clause(const int c) const { return clauses[c]; }
+
+    private:
+        struct Match
+        {
+            int literal;
+            int clause;
+        };
+
+        int add(const std::vector<int>& literals);
+        void remove(const int c);
+        void push(const int literal);
+        int rarest(const int c, const int except) const;
+        void findMatches(const int l, const std::vector<int>& matchedClauses);
+        int partner(const int c, const int l, const int m);
+        void replace(const int l, const std::vector<int>& matchedLiterals,
+                const std::vector<int>& matchedClauses, const int x);
+
+        std::vector<std::vector<int>> clauses;
+        std::vector<char> removed;
+        std::vector<std::vector<int>> occurrences;
+        std::vector<int> count;
+        std::priority_queue<std::pair<int, int>> queue;
+        std::vector<Match> matches;
+        // literals of the clause being matched
+        std::vector<char> marked;
+        std::uint64_t steps = 0;
+        std::uint64_t maxSteps;
+    };
+
+    Reencoder::Reencoder(const sat::Formula& formula, const std::uint64_t maxSteps):
+        occurrences(2 * (formula.numVariables() + 1)), count(occurrences.size(), 0),
+        marked(occurrences.size(), 0), maxSteps(maxSteps)
+    {
+        std::vector<int> literals;
+        for (const sat::Clause& clause: formula) {
+            literals.clear();
+            for (const sat::Literal& t: clause) {
+                literals.push_back(t.index());
+            }
+            add(literals);
+        }
+    }
+
+    int Reencoder::add(const std::vector<int>& literals)
+    {
+        const int c = static_cast<int>(clauses.size());
+        clauses.push_back(literals);
+        removed.push_back(0);
+        for (int x: literals) {
+            occurrences[x].push_back(c);
+            count[x]++;
+        }
+        return c;
+    }
+
+    void Reencoder::remove(const int c)
+    {
+        removed[c] = 1;
+        for (int x: clauses[c]) {
+            count[x]--;
+        }
+    }
+
+    void Reencoder::push(const int literal)
+    {
+        if (count[literal] > 1) {
+            queue.push({count[literal], literal});
+        }
+    }
+
+    // the literal of clause c other than except in the fewest clauses
+    int Reencoder::rarest(const int c, const int except) const
+    {
+        int best = -1;
+        for (int x: clauses[c]) {
+            if (x != except && (best < 0 || count[x] < count[best])) {
+                best = x;
+            }
+        }
+        return best;
+    }
+
+    // the literals m, with the matched clause c, for which (c without l)
+    // and m is a clause
+    void Reencoder::findMatches(const int l, const std::vector<int>& matchedClauses)
+    {
+        matches.clear();
+        for (int c: matchedClauses) {
+            const int x = rarest(c, l);
+            if (x < 0) {
+                continue;
+            }
+            for (int y: clauses[c]) {
+                marked[y] = y != l;
+            }
+            const std::size_t size = clauses[c].size();
+            for (int d: occurrences[x]) {
+                steps++;
+                if (removed[d] || d == c || clauses[d].size() != size) {
+                    continue;
+                }
+                int m = -1;
+                int unmarked = 0;
+                for (int y: clauses[d]) {
+                    if (!marked[y]) {
+                        m = y;
+                        unmarked++;
+                    }
+                }
+                if (unmarked == 1 && m != l) {
+                    matches.push_back({m, c});
+                }
+            }
+            for (int y: clauses[c]) {
+                marked[y] = 0;
+            }
+        }
+    }
+
+    // an unremoved clause (c without l) and m
+    int Reencoder::partner(const int c, const int l, const int m)
+    {
+        for (int y: clauses[c]) {
+            marked[y] = y != l;
+        }
+        int found = -1;
+        for (int d: occurrences[m]) {
+            if (removed[d] || clauses[d].size() != clauses[c].size()) {
+                continue;
+            }
+            if (std::all_of(clauses[d].begin(), clauses[d].end(),
+                        [&](int y) { return y == m || marked[y]; })) {
+                found = d;
+                break;
+            }
+        }
+        for (int y: clauses[c]) {
+            marked[y] = 0;
+        }
+        return found;
+    }
+
+    void Reencoder::replace(const int l, const std::vector<int>& matchedLiterals,
+            const std::vector<int>& matchedClauses, const int x)
+    {
+        const int positive = sat::Literal(x).index();
+        const int negative = sat::Literal(-x).index();
+        occurrences.resize(std::max<std::size_t>(occurrences.size(), positive + 2));
+        count.resize(occurrences.size(), 0);
+        marked.resize(occurrences.size(), 0);
+        std::unordered_set<int> touched;
+        for (int c: matchedClauses) {
+            for (int m: matchedLiterals) {
+                const int d = m == l ? c : partner(c, l, m);
+                if (d >= 0 && !removed[d]) {
+                    remove(d);
+                    touched.insert(clauses[d].begin(), clauses[d].end());
+                }
+            }
+        }
+        std::vector<int> literals;
+        for (int m: matchedLiterals) {
+            add({m, negative});
+        }
+        for (int c: matchedClauses) {
+            literals.clear();
+            for (int y: clauses[c]) {
+                if (y != l) {
+                    literals.push_back(y);
+                }
+            }
+            literals.push_back(positive);
+            add(literals);
+        }
+        touched.insert(positive);
+        touched.insert(negative);
+        for (int y: touched) {
+            push(y);
+        }
+    }
+
+    int Reencoder::run(const std::function<int()>& newVariable, const std::function<bool()>& stopped)
+    {
+        const int before = static_cast<int>(clauses.size());
+        for (int x = 2; x < static_cast<int>(count.size()); x++) {
+            push(x);
+        }
+        std::vector<int> matchedLiterals;
+        std::vector<int> matchedClauses;
+        std::vector<int> tally(count.size(), 0);
+        std::vector<int> tallied;
+        std::uint64_t nextPoll = POLL_STEPS;
+        while (!queue.empty() && steps < maxSteps) {
+            if (steps >= nextPoll) {
+                if (stopped()) {
+                    break;
+                }
+                nextPoll = steps + POLL_STEPS;
+            }
+            const std::pair<int, int> top = queue.top();
+            queue.pop();
+            const int l = top.second;
+            if (top.first != count[l]) {
+                // counts changed since it was pushed, pushed again then
+                continue;
+            }
+            matchedLiterals.assign(1, l);
+            matchedClauses.clear();
+            for (int c: occurrences[l]) {
+                if (!removed[c]) {
+                    matchedClauses.push_back(c);
+                }
+            }
+            // grows the literals by the one matching the most clauses, as
+            // long as that removes more clauses
+            while (steps < maxSteps) {
+                findMatches(l, matchedClauses);
+                tally.resize(count.size(), 0);
+                int best = -1;
+                for (const Match& match: matches) {
+                    if (tally[match.literal]++ == 0) {
+                        tallied.push_back(match.literal);
+                    }
+                    if (std::find(matchedLiterals.begin(), matchedLiterals.end(), match.literal)
+                            == matchedLiterals.end()
+                            && (best < 0 || tally[match.literal] > tally[best])) {
+                        best = match.literal;
+                    }
+                }
+                const int k = static_cast<int>(matchedLiterals.size());
+                const int n = static_cast<int>(matchedClauses.size());
+                const int bestCount = best < 0 ? 0 : tally[best];
+                for (int y: tallied) {
+                    tally[y] = 0;
+                }
+                tallied.clear();
+                if (best < 0 || (k + 1) * bestCount - (k + 1) - bestCount <= k * n - k - n) {
+                    break;
+                }
+                matchedLiterals.push_back(best);
+                matchedClauses.clear();
+                for (const Match& match: matches) {
+                    if (match.literal == best && (matchedClauses.empty()
+                                || matchedClauses.back() != match.clause)) {
+                        matchedClauses.push_back(match.clause);
+                    }
+                }
+            }
+            const int k = static_cast<int>(matchedLiterals.size());
+            const int n = static_cast<int>(matchedClauses.size());
+            if (k < 2 || k * n - k - n <= 0) {
+                continue;
+            }
+            replace(l, matchedLiterals, matchedClauses, newVariable());
+            push(l);
+        }
+        int after = 0;
+        for (char r: removed) {
+            after += !r;
+        }
+        return before - after;
+    }
+}
+
+int sat::boundedVariableAddition(Formula& formula, const std::function<int()>& newVariable,
+        const std::uint64_t maxSteps, const std::function<bool()>& stopped)
+{
+    Reencoder reencoder(formula, maxSteps);
+    const int numClauses = reencoder.numClauses();
+    const int reduction = reencoder.run(newVariable, stopped);
+    if (reduction == 0) {
+        return 0;
+    }
+    // clauses are matched to the formula by position
+    std::unordered_set<const Clause*> replaced;
+    int c = 0;
+    for (const Clause& clause: formula) {
+        if (reencoder.replaced(c++)) {
+            replaced.insert(&clause);
+        }
+    }
+    formula.removeClauses(0, [&](const Clause& clause) {
+        return replaced.find(&clause) != replaced.end();
+    });
+    std::vector<Literal> literals;
+    for (c = numClauses; c < reencoder.numClauses(); c++) {
+        if (!reencoder.replaced(c)) {
+            literals.clear();
+            for (int x: reencoder.clause(c)) {
+                literals.push_back(Literal::fromIndex(x));
+            }
+            formula.addClause(Clause(literals));
+        }
+    }
+    return reduction;
+}
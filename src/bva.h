@@ -0,0 +1,22 @@
+
+#ifndef SAT_BVA_H
+#define SAT_BVA_H
+
+#include "formula.h"
+#include <cstdint>
+#include <functional>
+
+namespace sat
+{
+    // bounded variable addition: the clauses (l or R) for every literal l
+    // of a set and every remainder R of a set are replaced by (l or -x)
+    // and (R or x), over a fresh variable x from newVariable, whenever this
+    // leaves fewer clauses; models of the result are models of the formula
+    // over its variables, and each model of the formula extends to one;
+    // stops after about maxSteps clause visits, or when polled stopped
+    // returns true, returns the number of clauses removed, net
+    int boundedVariableAddition(Formula& formula, const std::function<int()>& newVariable,
+            const std::uint64_t maxSteps, const std::function<bool()>& stopped);
+}
+
+#endif // SAT_BVA_H
@@ -0,0 +1,226 @@
+
+#include "cache.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    std::uint64_t combine(std::uint64_t h, const std::uint64_t x)
+    {
+        h ^= x;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        return h;
+    }
+
+    using Hash = std::pair<std::uint64_t, std::uint64_t>;
+
+    Hash combine(const Hash& h, const std::uint64_t x)
+    {
+        return {combine(h.first, x), combine(h.second, x)};
+    }
+
+    const Hash SEED = {0x9e3779b97f4a7c15ull, 0x2545f4914f6cdd1dull};
+
+    // closes the file when it goes out of scope, which releases its lock
+    class LockedFile
+    {
+    public:
+        LockedFile(const std::string& path, const int flags, const int operation)
+        {
+            do {
+                fd = ::open(path.c_str(), flags, 0644);
+            } while (fd < 0 && errno == EINTR);
+            if (fd < 0) {
+                return;
+            }
+            while (::flock(fd, operation) != 0) {
+                if (errno != EINTR) {
+                    ::close(fd);
+                    throw std::runtime_error("Cannot lock cache file " + path);
+                }
+            }
+        }
+        ~LockedFile()
+        {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+        LockedFile(const LockedFile&) = delete;
+        LockedFile& operator=(const LockedFile&) = delete;
+
+        int fd;
+    };
+
+    // a line "key sat 1 -2 ... 0" or "key unsat [proof]" after the key,
+    // false if it is malformed
+    bool parseEntry(const std::string& rest, sat::ResultCache::Entry& entry)
+    {
+        std::istringstream in(rest);
+        std::string result;
+        in >> result;
+        if (result == "unsat") {
+            entry.satisfiable = false;
+            entry.model.clear();
+            std::getline(in >> std::ws, entry.proof);
+            return true;
+        }
+        if (result != "sat") {
+            return false;
+        }
+        entry.satisfiable = true;
+        entry.model.clear();
+        entry.proof.clear();
+        long value;
+        while (in >> value) {
+            if (value == 0) {
+                return true;
+            }
+            const long var = static_cast<long>(entry.model.size()) + 1;
+            if (value != var && value != -var) {
+                return false;
+            }
+            entry.model.push_back(value > 0);
+        }
+        return false;
+    }
+}
+
+std::string sat::canonicalKey(const Formula& formula)
+{
+    // each clause hashed over its sorted literals, the formula over its
+    // sorted clause hashes
+    std::vector<Hash> clauses;
+    clauses.reserve(formula.numClauses());
+    std::vector<int> literals;
+    for (const Clause& clause: formula) {
+        literals.clear();
+        for (const Literal& t: clause) {
+            literals.push_back(t.index());
+        }
+        std::sort(literals.begin(), literals.end());
+        Hash h = combine(SEED, literals.size());
+        for (int x: literals) {
+            h = combine(h, x);
+        }
+        clauses.push_back(h);
+    }
+    std::sort(clauses.begin(), clauses.end());
+    Hash h = combine(SEED, formula.numVariables());
+    for (const Hash& c: clauses) {
+        h = combine(combine(h, c.first), c.second);
+    }
+    std::ostringstream key;
+    key << std::hex << std::setfill('0') << std::setw(16) << h.first << std::setw(16) << h.second;
+    return key.str();
+}
+
+bool sat::satisfies(const Formula& formula, const std::vector<bool>& values)
+{
+    if (static_cast<int>(values.size()) != formula.numVariables()) {
+        return false;
+    }
+    for (const Clause& clause: formula) {
+        if (std::none_of(clause.begin(), clause.end(),
+                    [&](const Literal& t) { return values[t.id() - 1] == t.polarity(); })) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool sat::ResultCache::lookup(const std::string& key, Entry& entry) const
+{
+    LockedFile file(path, O_RDONLY, LOCK_SH);
+    if (file.fd < 0) {
+        if (errno == ENOENT) {
+            return false;
+        }
+        throw std::runtime_error("Cannot open cache file " + path);
+    }
+    // whole lines only, a later entry replaces an earlier one
+    const std::string prefix = key + ' ';
+    bool found = false;
+    std::string pending;
+    std::vector<char> buffer(1 << 16);
+    while (true) {
+        const ssize_t n = ::read(file.fd, buffer.data(), buffer.size());
+        if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0) {
+            throw std::runtime_error("Cannot read cache file " + path);
+        } else if (n == 0) {
+            break;
+        }
+        pending.append(buffer.data(), n);
+        std::size_t start = 0;
+        std::size_t end;
+        while ((end = pending.find('\n', start)) != std::string::npos) {
+            if (pending.compare(start, prefix.size(), prefix) == 0) {
+                Entry parsed;
+                if (parseEntry(pending.substr(start + prefix.size(), end - start - prefix.size()),
+                            parsed)) {
+                    entry = std::move(parsed);
+                    found = true;
+                }
+            }
+            start = end + 1;
+        }
+        pending.erase(0, start);
+    }
+    return found;
+}
+
+void sat::ResultCache::store(const std::string& key, const Entry& entry) const
+{
+    std::string line = key;
+    if (entry.satisfiable) {
+        line += " sat";
+        for (std::size_t i = 0; i < entry.model.size(); i++) {
+            line += entry.model[i] ? " " : " -";
+            line += std::to_string(i + 1);
+        }
+        line += " 0";
+    } else {
+        line += " unsat";
+        if (!entry.proof.empty() && entry.proof.find('\n') == std::string::npos) {
+            line += " " + entry.proof;
+        }
+    }
+    line += '\n';
+    // appended in one piece under the exclusive lock, so readers never
+    // see a partial line of a finished write
+    LockedFile file(path, O_RDWR | O_APPEND | O_CREAT, LOCK_EX);
+    if (file.fd < 0) {
+        throw std::runtime_error("Cannot open cache file " + path);
+    }
+    // the partial line of an interrupted write is ended first
+    struct stat status;
+    char last = '\n';
+    if (::fstat(file.fd, &status) == 0 && status.st_size > 0
+            && ::pread(file.fd, &last, 1, status.st_size - 1) == 1 && last != '\n') {
+        line.insert(line.begin(), '\n');
+    }
+    std::size_t written = 0;
+    while (written < line.size()) {
+        const ssize_t n = ::write(file.fd, line.data() + written, line.size() - written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0) {
+            throw std::runtime_error("Cannot write cache file " + path);
+        }
+        written += n;
+    }
+}
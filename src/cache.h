@@ -0,0 +1,42 @@
+
+#ifndef SAT_CACHE_H
+#define SAT_CACHE_H
+
+#include "formula.h"
+#include <string>
+#include <vector>
+
+namespace sat
+{
+    // 128 bit hash of a formula in hexadecimal, the same for any order of
+    // its clauses and of the literals within them
+    std::string canonicalKey(const Formula& formula);
+
+    // if values, indexed from variable 1 on, satisfy every clause
+    bool satisfies(const Formula& formula, const std::vector<bool>& values);
+
+    // results by canonical key, appended as lines of a file that processes
+    // share under flock, a shared lock to read and an exclusive one to append
+    class ResultCache
+    {
+    public:
+        struct Entry
+        {
+            bool satisfiable;
+            // values of variables from 1 on when satisfiable
+            std::vector<bool> model;
+            // file of a proof of unsatisfiability, if one was written
+            std::string proof;
+        };
+
+        explicit ResultCache(const std::string& path): path(path) {}
+        // the entry stored last for key, false if there is none
+        bool lookup(const std::string& key, Entry& entry) const; // can throw
+        void store(const std::string& key, const Entry& entry) const; // can throw
+
+    private:
+        std::string path;
+    };
+}
+
+#endif // SAT_CACHE_H
@@ -0,0 +1,384 @@
+
+#include "cardinality.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace
+{
+    // sorted literal indices of a clause, padded with -1
+    const int MAX_EDGE = 4;
+    // lookups of completions between polls of the stop callback
+    const std::uint64_t POLL_STEPS = 1 << 16;
+    using Key = std::array<int, MAX_EDGE>;
+
+    struct KeyHash
+    {
+        std::size_t operator()(const Key& key) const
+        {
+            std::uint64_t h = 0;
+            for (int x: key) {
+                h = (h + static_cast<std::uint32_t>(x)) * 0x9e3779b97f4a7c15ull;
+                h ^= h >> 29;
+            }
+            return h;
+        }
+    };
+
+    // elems and extra, if not negative
+    Key makeKey(const std::vector<int>& elems, const int extra)
+    {
+        Key key;
+        key.fill(-1);
+        int n = 0;
+        auto insert = [&](int x) {
+            // insertion sort, at most MAX_EDGE elements
+            int i = n++;
+            for (; i > 0 && key[i-1] > x; i--) {
+                key[i] = key[i-1];
+            }
+            key[i] = x;
+        };
+        for (int x: elems) {
+            insert(x);
+        }
+        if (extra >= 0) {
+            insert(extra);
+        }
+        return key;
+    }
+
+    // a clause of k+1 literals over the complements of its literals
+    struct Edge
+    {
+        Key key;
+        const sat::Clause* clause;
+        bool covered;
+    };
+
+    // the literal making an edge with a key of k literals
+    struct Completion
+    {
+        int literal;
+        int edge;
+    };
+
+    long binomial(const int n, const int k)
+    {
+        long result = 1;
+        for (int i = 0; i < k; i++) {
+            result = result * (n - i) / (i + 1);
+        }
+        return k > n ? 0 : result;
+    }
+
+    // calls f on each subset of the given size, in order of elems;
+    // stops and returns false as soon as f returns false
+    template <class Function>
+    bool forEachSubset(const std::vector<int>& elems, const int size, Function f)
+    {
+        const int n = elems.size();
+        if (size > n) {
+            return true;
+        }
+        std::vector<int> index(size);
+        std::vector<int> subset(size);
+        for (int i = 0; i < size; i++) {
+            index[i] = i;
+        }
+        while (true) {
+            for (int i = 0; i < size; i++) {
+                subset[i] = elems[index[i]];
+            }
+            if (!f(subset)) {
+                return false;
+            }
+            int i = size - 1;
+            while (i >= 0 && index[i] == n - size + i) {
+                i--;
+            }
+            if (i < 0) {
+                return true;
+            }
+            index[i]++;
+            for (int j = i + 1; j < size; j++) {
+                index[j] = index[j-1] + 1;
+            }
+        }
+    }
+
+    // k literals of the edge, all but the one at i
+    Key without(const Key& key, const int i)
+    {
+        Key rest(key);
+        std::copy(rest.begin() + i + 1, rest.end(), rest.begin() + i);
+        rest[MAX_EDGE - 1] = -1;
+        return rest;
+    }
+
+    // edges in a group of k+2 literals or more share each k of their literals
+    // with another edge of it; the others are dropped, so that unstructured
+    // formulas cost a count of their clauses; k literals are counted by
+    // literal for k = 1, and in hashed slots above, which may keep a few more
+    std::vector<Edge> groupable(std::vector<Edge>&& edges, const int k, const int numLiterals)
+    {
+        const std::size_t subsets = edges.size() * (k + 1);
+        std::size_t size = k == 1 ? numLiterals : 1;
+        while (k > 1 && size < 4 * subsets) {
+            size *= 2;
+        }
+        auto slot = [&](const Key& rest) {
+            return k == 1 ? static_cast<std::size_t>(rest[0]) : KeyHash()(rest) & (size - 1);
+        };
+        std::vector<std::uint8_t> count(size, 0);
+        for (const Edge& edge: edges) {
+            for (int i = 0; i <= k; i++) {
+                std::uint8_t& c = count[slot(without(edge.key, i))];
+                c = std::min(c + 1, 2);
+            }
+        }
+        std::vector<Edge> kept;
+        for (const Edge& edge: edges) {
+            bool shared = true;
+            for (int i = 0; i <= k && shared; i++) {
+                shared = count[slot(without(edge.key, i))] >= 2;
+            }
+            if (shared) {
+                kept.push_back(edge);
+            }
+        }
+        return kept;
+    }
+}
+
+std::vector<sat::AtMostK> sat::findAtMostK(const Formula& formula, const int maxK,
+        std::unordered_set<const Clause*>& covered, const std::function<bool()>& stopped)
+{
+    if (maxK >= MAX_EDGE) {
+        throw std::invalid_argument("Cardinality bound too large");
+    }
+    std::vector<AtMostK> found;
+    std::vector<int> literals;
+    std::vector<int> count(2 * (formula.numVariables() + 1), 0);
+    std::vector<char> inGroup(count.size(), 0);
+    std::vector<int> touched;
+    std::vector<int> group;
+    std::uint64_t steps = 0;
+    std::uint64_t nextPoll = 0;
+    for (int k = 1; k <= maxK; k++) {
+        // the literals of an edge cannot all be true; completions of k of
+        // them are the literals that make an edge with them
+        std::vector<Edge> edges;
+        for (const Clause& clause: formula) {
+            if (static_cast<int>(clause.size()) != k + 1) {
+                continue;
+            }
+            literals.clear();
+            for (const Literal& t: clause) {
+                literals.push_back(t.negate().index());
+            }
+            edges.push_back({makeKey(literals, -1), &clause, false});
+        }
+        edges = groupable(std::move(edges), k, static_cast<int>(count.size()));
+        if (static_cast<int>(edges.size()) < k + 2) {
+            continue;
+        }
+        // duplicates of an edge stay clauses, marked covered to be ignored;
+        // edges are kept in clause order, encodings list a group together
+        const int numEdges = edges.size();
+        std::vector<int> order(numEdges);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(),
+                [&](int e1, int e2) { return edges[e1].key < edges[e2].key; });
+        for (int i = 1; i < numEdges; i++) {
+            if (edges[order[i]].key == edges[order[i-1]].key) {
+                edges[order[i]].covered = true;
+            }
+        }
+        std::unordered_map<Key, std::vector<Completion>, KeyHash> completions;
+        for (int e = 0; e < numEdges; e++) {
+            if (edges[e].covered) {
+                continue;
+            }
+            for (int i = 0; i <= k; i++) {
+                completions[without(edges[e].key, i)].push_back({edges[e].key[i], e});
+            }
+        }
+
+        // count[y] is the number of k literals of the group that make an
+        // edge with y, not yet covered by another group
+        auto join = [&](const int x) {
+            forEachSubset(group, k - 1, [&](const std::vector<int>& rest) {
+                steps++;
+                auto it = completions.find(makeKey(rest, x));
+                if (it != completions.end()) {
+                    for (const Completion& c: it->second) {
+                        if (!edges[c.edge].covered && count[c.literal]++ == 0) {
+                            touched.push_back(c.literal);
+                        }
+                    }
+                }
+                return true;
+            });
+            group.push_back(x);
+            inGroup[x] = 1;
+        };
+
+        // greedy growth of groups where every k+1 literals are an edge
+        const std::size_t maxGroup = k == 1 ? 256 : 32;
+        for (const Edge& seed: edges) {
+            if (seed.covered) {
+                continue;
+            }
+            if (steps >= nextPoll) {
+                if (stopped()) {
+                    return found;
+                }
+                nextPoll = steps + POLL_STEPS;
+            }
+            for (int i = 0; i <= k; i++) {
+                join(seed.key[i]);
+            }
+            Key first(seed.key);
+            first[k] = -1;
+            for (const Completion& c: completions.at(first)) {
+                const int y = c.literal;
+                if (group.size() >= maxGroup) {
+                    break;
+                }
+                if (!inGroup[y] && !inGroup[y ^ 1] && count[y] == binomial(group.size(), k)) {
+                    join(y);
+                }
+            }
+            if (static_cast<int>(group.size()) >= k + 2) {
+                AtMostK constraint{std::vector<Literal>(), k};
+                for (int x: group) {
+                    constraint.literals.push_back(Literal::fromIndex(x));
+                }
+                found.push_back(std::move(constraint));
+                forEachSubset(group, k, [&](const std::vector<int>& subset) {
+                    for (const Completion& c: completions.at(makeKey(subset, -1))) {
+                        Edge& edge = edges[c.edge];
+                        if (inGroup[c.literal] && !edge.covered) {
+                            edge.covered = true;
+                            covered.insert(edge.clause);
+                        }
+                    }
+                    return true;
+                });
+            }
+            for (int y: touched) {
+                count[y] = 0;
+            }
+            for (int x: group) {
+                inGroup[x] = 0;
+            }
+            touched.clear();
+            group.clear();
+        }
+    }
+    return found;
+}
+
+sat::Cardinality::Cardinality(std::vector<AtMostK>&& constraints, const Assignment& assignment):
+    assignment(assignment), constraints(std::move(constraints)),
+    occurrences(2 * (assignment.total() + 1))
+{
+    numTrue.resize(this->constraints.size(), 0);
+    for (int c = 0; c < numConstraints(); c++) {
+        for (const Literal& t: this->constraints[c].literals) {
+            occurrences[t.index()].push_back(c);
+        }
+    }
+}
+
+bool sat::Cardinality::assigned(const Literal& t, std::vector<Implication>& implied)
+{
+    // every count is updated, even after a conflict; variables added
+    // after construction are in no constraint
+    if (t.index() >= static_cast<int>(occurrences.size())) {
+        return true;
+    }
+    bool ok = true;
+    for (int c: occurrences[t.index()]) {
+        numTrue[c]++;
+        if (!ok) {
+            continue;
+        }
+        if (numTrue[c] > constraints[c].k) {
+            setConflict(c, t);
+            ok = false;
+        } else if (numTrue[c] == constraints[c].k) {
+            imply(c, implied);
+        }
+    }
+    return ok;
+}
+
+void sat::Cardinality::unassigned(const Literal& t)
+{
+    if (t.index() >= static_cast<int>(occurrences.size())) {
+        return;
+    }
+    for (int c: occurrences[t.index()]) {
+        numTrue[c]--;
+    }
+}
+
+void sat::Cardinality::imply(const int c, std::vector<Implication>& implied) const
+{
+    for (const Literal& t: constraints[c].literals) {
+        if (!assignment.isAssigned(t)) {
+            implied.push_back({t.negate(), c});
+        }
+    }
+}
+
+void sat::Cardinality::setConflict(const int c, const Literal& t)
+{
+    // t and k other true literals cannot all be true
+    conflictLiterals.clear();
+    conflictLiterals.push_back(t.negate());
+    for (const Literal& other: constraints[c].literals) {
+        if (static_cast<int>(conflictLiterals.size()) > constraints[c].k) {
+            break;
+        }
+        if (other != t && assignment.isTrue(other)) {
+            conflictLiterals.push_back(other.negate());
+        }
+    }
+}
+
+void sat::Cardinality::explain(const Literal& t, const int constraint,
+        std::vector<Literal>& clause) const
+{
+    clause.push_back(t);
+    for (const Literal& other: constraints[constraint].literals) {
+        if (assignment.isTrue(other) && assignment.precedes(other, t)) {
+            clause.push_back(other.negate());
+        }
+    }
+}
+
+std::vector<std::vector<sat::Literal>> sat::Cardinality::encoding() const
+{
+    std::vector<std::vector<Literal>> clauses;
+    for (const AtMostK& constraint: constraints) {
+        std::vector<int> indices;
+        for (const Literal& t: constraint.literals) {
+            indices.push_back(t.negate().index());
+        }
+        forEachSubset(indices, constraint.k + 1, [&](const std::vector<int>& subset) {
+            std::vector<Literal> clause;
+            for (int x: subset) {
+                clause.push_back(Literal::fromIndex(x));
+            }
+            clauses.push_back(std::move(clause));
+            return true;
+        });
+    }
+    return clauses;
+}
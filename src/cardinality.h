@@ -0,0 +1,69 @@
+
+#ifndef SAT_CARDINALITY_H
+#define SAT_CARDINALITY_H
+
+#include "formula.h"
+#include "assignment.h"
+#include <functional>
+#include <unordered_set>
+#include <vector>
+
+namespace sat
+{
+    // at most k of the literals are true
+    struct AtMostK
+    {
+        std::vector<Literal> literals;
+        int k;
+    };
+
+    // recovers at-most-k constraints, k up to maxK < 4, from their binomial
+    // encodings: every k+1 of the literals have a clause of their complements,
+    // pairwise binary clauses for at-most-one; clauses of the encodings are
+    // added to covered; polls stopped, and returns the constraints found so
+    // far once it returns true
+    std::vector<AtMostK> findAtMostK(const Formula& formula, const int maxK,
+            std::unordered_set<const Clause*>& covered,
+            const std::function<bool()>& stopped); // can throw
+
+    // counts the true literals of each constraint; at k the other literals
+    // are implied false, above k it is a conflict; explanations are only
+    // built when conflict analysis asks for them
+    class Cardinality
+    {
+    public:
+        struct Implication
+        {
+            Literal literal;
+            int constraint;
+        };
+
+        Cardinality(std::vector<AtMostK>&& constraints, const Assignment& assignment);
+        int numConstraints() const { return static_cast<int>(constraints.size()); }
+
+        // counts start at zero, every literal assigned is given to assigned;
+        // after t is assigned, returns false on a conflict
+        bool assigned(const Literal& t, std::vector<Implication>& implied);
+        // before t is unassigned, for every t given to assigned
+        void unassigned(const Literal& t);
+        // falsified clause of the last conflict
+        const std::vector<Literal>& conflict() const { return conflictLiterals; }
+        // clause, t first, over constraint literals assigned before t implied by it
+        void explain(const Literal& t, const int constraint, std::vector<Literal>& clause) const;
+        // the clauses of the binomial encoding of every constraint
+        std::vector<std::vector<Literal>> encoding() const;
+
+    private:
+        void imply(const int c, std::vector<Implication>& implied) const;
+        void setConflict(const int c, const Literal& t);
+
+        const Assignment& assignment;
+        std::vector<AtMostK> constraints;
+        std::vector<int> numTrue;
+        // constraint indices, indexed by Literal::index()
+        std::vector<std::vector<int>> occurrences;
+        std::vector<Literal> conflictLiterals;
+    };
+}
+
+#endif // SAT_CARDINALITY_H
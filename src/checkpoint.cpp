@@ -0,0 +1,144 @@
+
+#include "checkpoint.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+namespace
+{
+    const char MAGIC[8] = {'S', 'A', 'T', 'C', 'K', 'P', 'T', '\n'};
+    const std::uint32_t VERSION = 1;
+
+    template <class T>
+    void put(std::ofstream& out, const T& value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <class T>
+    void putArray(std::ofstream& out, const std::vector<T>& values)
+    {
+        out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    }
+
+    void putLiterals(std::ofstream& out, const std::vector<sat::Literal>& literals)
+    {
+        put(out, static_cast<std::uint32_t>(literals.size()));
+        for (const sat::Literal& t: literals) {
+            put(out, static_cast<std::int32_t>(t.index()));
+        }
+    }
+
+    template <class T>
+    T get(std::ifstream& in)
+    {
+        T value;
+        if (!in.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+            throw std::runtime_error("Truncated checkpoint");
+        }
+        return value;
+    }
+
+    template <class T>
+    void getArray(std::ifstream& in, std::vector<T>& values, const std::size_t size)
+    {
+        values.resize(size);
+        if (!in.read(reinterpret_cast<char*>(values.data()), size * sizeof(T))) {
+            throw std::runtime_error("Truncated checkpoint");
+        }
+    }
+
+    // at most numVars literals, over variables up to numVars
+    std::vector<sat::Literal> getLiterals(std::ifstream& in, const int numVars)
+    {
+        const std::uint32_t size = get<std::uint32_t>(in);
+        if (size > static_cast<std::uint32_t>(numVars)) {
+            throw std::runtime_error("Invalid checkpoint clause");
+        }
+        std::vector<sat::Literal> literals;
+        literals.reserve(size);
+        for (std::uint32_t i = 0; i < size; i++) {
+            const std::int32_t index = get<std::int32_t>(in);
+            if (index < 2 || index > 2 * numVars + 1) {
+                throw std::runtime_error("Invalid checkpoint literal");
+            }
+            literals.push_back(sat::Literal::fromIndex(index));
+        }
+        return literals;
+    }
+}
+
+void sat::writeCheckpoint(const std::string& path, const Checkpoint& checkpoint)
+{
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("Cannot open checkpoint file " + temporary);
+        }
+        out.write(MAGIC, sizeof(MAGIC));
+        put(out, VERSION);
+        put(out, checkpoint.formulaHash);
+        put(out, static_cast<std::int32_t>(checkpoint.numVars));
+        put(out, static_cast<std::uint32_t>(checkpoint.counters.size()));
+        putArray(out, checkpoint.counters);
+        putLiterals(out, checkpoint.units);
+        std::vector<char> phases(checkpoint.phases.begin(), checkpoint.phases.end());
+        putArray(out, phases);
+        putArray(out, checkpoint.activities);
+        put(out, static_cast<std::uint64_t>(checkpoint.learned.size()));
+        for (const Checkpoint::LearnedClause& clause: checkpoint.learned) {
+            put(out, clause.lbd);
+            putLiterals(out, clause.literals);
+        }
+        out.close();
+        if (!out) {
+            throw std::runtime_error("Cannot write checkpoint file " + temporary);
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Cannot rename checkpoint file to " + path);
+    }
+}
+
+sat::Checkpoint sat::readCheckpoint(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot open checkpoint file " + path);
+    }
+    char magic[sizeof(MAGIC)];
+    if (!in.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), MAGIC)) {
+        throw std::runtime_error("Not a checkpoint file " + path);
+    }
+    if (get<std::uint32_t>(in) != VERSION) {
+        throw std::runtime_error("Unsupported checkpoint version");
+    }
+    Checkpoint checkpoint;
+    checkpoint.formulaHash = get<std::uint64_t>(in);
+    checkpoint.numVars = get<std::int32_t>(in);
+    const int numVars = checkpoint.numVars;
+    if (numVars < 0) {
+        throw std::runtime_error("Invalid checkpoint variables");
+    }
+    const std::uint32_t numCounters = get<std::uint32_t>(in);
+    if (numCounters > 64) {
+        throw std::runtime_error("Invalid checkpoint counters");
+    }
+    getArray(in, checkpoint.counters, numCounters);
+    checkpoint.units = getLiterals(in, numVars);
+    std::vector<char> phases;
+    getArray(in, phases, numVars + 1);
+    checkpoint.phases.assign(phases.begin(), phases.end());
+    getArray(in, checkpoint.activities, numVars + 1);
+    const std::uint64_t numLearned = get<std::uint64_t>(in);
+    for (std::uint64_t i = 0; i < numLearned; i++) {
+        const std::uint32_t lbd = get<std::uint32_t>(in);
+        checkpoint.learned.push_back({getLiterals(in, numVars), lbd});
+    }
+    if (in.peek() != std::ifstream::traits_type::eof()) {
+        throw std::runtime_error("Trailing data in checkpoint");
+    }
+    return checkpoint;
+}
@@ -0,0 +1,41 @@
+
+#ifndef SAT_CHECKPOINT_H
+#define SAT_CHECKPOINT_H
+
+#include "literal.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sat
+{
+    // solver state to continue a solve from: everything in it is implied
+    // by the formula it was saved for, identified by its hash
+    struct Checkpoint
+    {
+        struct LearnedClause
+        {
+            std::vector<Literal> literals;
+            std::uint32_t lbd;
+        };
+
+        std::uint64_t formulaHash = 0;
+        int numVars = 0;
+        // statistics counters, in the order the solver saves them
+        std::vector<std::uint64_t> counters;
+        std::vector<Literal> units;
+        // indexed by variable, index 0 is unused
+        std::vector<bool> phases;
+        std::vector<double> activities;
+        std::vector<LearnedClause> learned;
+    };
+
+    // versioned binary format in native byte order; written to a temporary
+    // file renamed over path, so an interrupted write keeps the old one
+    void writeCheckpoint(const std::string& path, const Checkpoint& checkpoint); // can throw
+    // throws runtime_error for files of another version, and truncated or
+    // inconsistent ones
+    Checkpoint readCheckpoint(const std::string& path); // can throw
+}
+
+#endif // SAT_CHECKPOINT_H
@@ -3,24 +3,37 @@
 #define SAT_CLAUSE_H
 
 #include "literal.h"
+#include "assignment.h"
+#include "debug.h"
+#include "scan.h"
+#include <cstdint>
 #include <ostream>
 #include <vector>
+#include <utility>
 
 namespace sat
 {
-    class Assignment;
     class Clause
     {
     public:
         explicit Clause(const std::vector<int>& input);
         explicit Clause(std::vector<Literal>& input);
-        std::size_t size() const;
-        bool empty() const;
+        std::size_t size() const noexcept { return literals.size(); }
+        bool empty() const noexcept { return literals.empty(); }
 
-        const Literal& w1() const;
-        const Literal& w2() const;
-        void swapWatches();
-        bool moveW2(Assignment& assignment);
+        // unchecked, the clause must have at least two literals,
+        // validated only in DEBUG builds
+        const Literal& w1() const noexcept;
+        const Literal& w2() const noexcept;
+        void swapWatches() noexcept;
+        bool moveW2(const Assignment& assignment) noexcept;
+        const Literal& operator[](const std::size_t i) const noexcept;
+
+        const Literal& at(const std::size_t i) const; // can throw
+        // literal block distance of a learned clause when it was learned:
+        // the number of decision levels of its literals; 0 for others
+        std::uint32_t lbd() const noexcept { return glue; }
+        void setLbd(const std::uint32_t lbd) noexcept { glue = lbd; }
 
         class const_iterator
         {
@@ -44,14 +57,77 @@ namespace sat
             friend class Clause;
         };
 
-        const_iterator begin() const;
-        const_iterator end() const;
+        const_iterator begin() const { return const_iterator(literals.begin()); }
+        const_iterator end() const { return const_iterator(literals.end()); }
 
     private:
+        std::size_t findNotFalse(const std::size_t begin, const std::size_t end,
+                const signed char* values) const noexcept;
+
         std::vector<Literal> literals;
+        // where the last replacement watch was found
+        std::uint32_t searchPos = 2;
+        std::uint32_t glue = 0;
     };
 
     std::ostream& operator<<(std::ostream& out, const sat::Clause& clause);
+
+    inline const Literal& Clause::w1() const noexcept
+    {
+        DBGASSERT(literals.size() >= 2, "watched clause " << *this << " is too short");
+        return literals[0];
+    }
+
+    inline const Literal& Clause::w2() const noexcept
+    {
+        DBGASSERT(literals.size() >= 2, "watched clause " << *this << " is too short");
+        return literals[1];
+    }
+
+    inline void Clause::swapWatches() noexcept
+    {
+        DBGASSERT(literals.size() >= 2, "watched clause " << *this << " is too short");
+        std::swap(literals[0], literals[1]);
+    }
+
+    inline bool Clause::moveW2(const Assignment& assignment) noexcept
+    {
+        // resume from the last replacement watch, wrapping around
+        // to the first unwatched literal
+        const std::size_t n = literals.size();
+        const std::size_t pos = searchPos < n ? searchPos : 2;
+        const signed char* values = assignment.literalValues();
+        std::size_t i = findNotFalse(pos, n, values);
+        if (i == n) {
+            i = findNotFalse(2, pos, values);
+            if (i == pos) {
+                return false;
+            }
+        }
+        std::swap(literals[1], literals[i]);
+        searchPos = static_cast<std::uint32_t>(i);
+        return true;
+    }
+
+    inline std::size_t Clause::findNotFalse(const std::size_t begin,
+            const std::size_t end, const signed char* values) const noexcept
+    {
+        if (end - begin >= scan::MIN_KERNEL_LENGTH) {
+            return scan::findNotFalse(literals.data(), begin, end, values);
+        }
+        for (std::size_t i = begin; i < end; i++) {
+            if (values[literals[i].index()] >= 0) {
+                return i;
+            }
+        }
+        return end;
+    }
+
+    inline const Literal& Clause::operator[](const std::size_t i) const noexcept
+    {
+        DBGASSERT(i < literals.size(), "literal index " << i << " out of range");
+        return literals[i];
+    }
 }
 
 #endif // SAT_CLAUSE_H
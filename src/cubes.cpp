@@ -0,0 +1,60 @@
+
+#include "solver.h"
+#include "budget.h"
+
+template <class Config>
+void sat::Solver<Config>::solveCubes(CubeSource& cubes, const int timeLimitSeconds)
+{
+    Watchdog watchdog(budget, std::chrono::seconds(timeLimitSeconds));
+    sharing = true;
+    propagateUnits();
+    if (!hasConflict) {
+        initCardinality();
+        reencode();
+    }
+    if (!hasConflict) {
+        processSingleLiteralClauses();
+    }
+    if (hasConflict) {
+        setUnsatisfiable();
+    } else {
+        initXors();
+    }
+    if (result == Result::Unknown) {
+        rephase();
+    }
+    // a model of the formula, or its refutation, holds for every cube
+    std::vector<Literal> cube;
+    std::vector<std::vector<Literal>> clauses;
+    while (cubes.next(cube, clauses)) {
+        if (!core.empty()) {
+            // unsatisfiable only under the cube before
+            result = Result::Unknown;
+            core.clear();
+        }
+        for (const std::vector<Literal>& clause: clauses) {
+            if (result == Result::Unknown) {
+                addClause(clause);
+            }
+        }
+        if (result == Result::Unknown) {
+            assumptions = cube;
+            search();
+            backtrack(0);
+            assumptions.clear();
+        }
+        cubes.finished(result, model, sharedClauses);
+        sharedClauses.clear();
+    }
+}
+
+namespace sat
+{
+    template void Solver<DefaultConfig<false, false>>::solveCubes(CubeSource&, const int);
+
+    template void Solver<DefaultConfig<false, true>>::solveCubes(CubeSource&, const int);
+
+    template void Solver<DefaultConfig<true, false>>::solveCubes(CubeSource&, const int);
+
+    template void Solver<DefaultConfig<true, true>>::solveCubes(CubeSource&, const int);
+}
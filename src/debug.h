@@ -3,6 +3,7 @@
 #define SAT_DEBUG_H
 
 #include <iostream>
+#include <cstdlib>
 
 #ifdef DEBUG
 #define ENABLE_DBGPRINT 1
@@ -12,6 +13,11 @@
 
 #define DBGPRINT(x) do { if (ENABLE_DBGPRINT) std::cerr << x << std::endl; } while (0)
 
+// validation of unchecked fast-path APIs, compiled out unless DEBUG
+#define DBGASSERT(c, x) do { if (ENABLE_DBGPRINT && !(c)) { \
+            std::cerr << "assertion failed: " << x << std::endl; \
+            std::abort(); } } while (0)
+
 #define DBGPRINTC(x, c) do { if (ENABLE_DBGPRINT) \
             sat::DBG_printIterable(std::cerr << x, c.begin(), c.end()) \
             << std::endl; } while (0)
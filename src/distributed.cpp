@@ -0,0 +1,619 @@
+
+#include "distributed.h"
+#include "cache.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+    const std::string UNIX_PREFIX = "unix:";
+    const int POLL_MILLISECONDS = 100;
+    const int CONNECT_SECONDS = 10;
+    // a worker not taking its messages for this long is dropped
+    const int SEND_SECONDS = 10;
+    // lost TCP peers are noticed after idle plus count times interval
+    const int KEEPALIVE_IDLE = 10;
+    const int KEEPALIVE_INTERVAL = 5;
+    const int KEEPALIVE_COUNT = 3;
+    const std::size_t MAX_LINE = 1 << 26;
+
+    bool isUnix(const std::string& address)
+    {
+        return address.compare(0, UNIX_PREFIX.size(), UNIX_PREFIX) == 0;
+    }
+
+    sockaddr_un unixAddress(const std::string& address)
+    {
+        const std::string path = address.substr(UNIX_PREFIX.size());
+        sockaddr_un result;
+        std::memset(&result, 0, sizeof(result));
+        result.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(result.sun_path)) {
+            throw std::runtime_error("Invalid socket path " + path);
+        }
+        std::memcpy(result.sun_path, path.c_str(), path.size() + 1);
+        return result;
+    }
+
+    // the addresses of host:port, where host may be empty when listening
+    addrinfo* resolve(const std::string& address, const bool listening)
+    {
+        const std::size_t colon = address.rfind(':');
+        if (colon == std::string::npos || colon + 1 == address.size()) {
+            throw std::runtime_error("Invalid address " + address);
+        }
+        const std::string host = address.substr(0, colon);
+        const std::string port = address.substr(colon + 1);
+        addrinfo hints;
+        std::memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = listening ? AI_PASSIVE : 0;
+        addrinfo* addresses = nullptr;
+        if (::getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints,
+                    &addresses) != 0) {
+            throw std::runtime_error("Cannot resolve address " + address);
+        }
+        return addresses;
+    }
+
+    void setOption(const int fd, const int level, const int option, const int value)
+    {
+        ::setsockopt(fd, level, option, &value, sizeof(value));
+    }
+
+    void keepAlive(const int fd)
+    {
+        setOption(fd, SOL_SOCKET, SO_KEEPALIVE, 1);
+        setOption(fd, IPPROTO_TCP, TCP_KEEPIDLE, KEEPALIVE_IDLE);
+        setOption(fd, IPPROTO_TCP, TCP_KEEPINTVL, KEEPALIVE_INTERVAL);
+        setOption(fd, IPPROTO_TCP, TCP_KEEPCNT, KEEPALIVE_COUNT);
+    }
+
+    // a connected socket, -1 if there is no one listening yet
+    int tryConnect(const std::string& address)
+    {
+        if (isUnix(address)) {
+            const sockaddr_un peer = unixAddress(address);
+            const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (fd >= 0 && ::connect(fd, reinterpret_cast<const sockaddr*>(&peer), sizeof(peer)) == 0) {
+                return fd;
+            }
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            return -1;
+        }
+        addrinfo* addresses = resolve(address, false);
+        int fd = -1;
+        for (addrinfo* a = addresses; a != nullptr && fd < 0; a = a->ai_next) {
+            fd = ::socket(a->ai_family, a->ai_socktype | SOCK_CLOEXEC, a->ai_protocol);
+            if (fd >= 0 && ::connect(fd, a->ai_addr, a->ai_addrlen) != 0) {
+                ::close(fd);
+                fd = -1;
+            }
+        }
+        ::freeaddrinfo(addresses);
+        if (fd >= 0) {
+            keepAlive(fd);
+        }
+        return fd;
+    }
+
+    // the coordinator may be started after its workers
+    int connectTo(const std::string& address)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(CONNECT_SECONDS);
+        while (true) {
+            const int fd = tryConnect(address);
+            if (fd >= 0) {
+                return fd;
+            } else if (std::chrono::steady_clock::now() >= deadline) {
+                throw std::runtime_error("Cannot connect to " + address);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(POLL_MILLISECONDS));
+        }
+    }
+
+    bool sendAll(const int fd, const std::string& data)
+    {
+        std::size_t sent = 0;
+        while (sent < data.size()) {
+            const ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            } else if (n <= 0) {
+                return false;
+            }
+            sent += n;
+        }
+        return true;
+    }
+
+    // appends what can be read to input, false at the end or on an error
+    bool receiveSome(const int fd, std::string& input)
+    {
+        char buffer[1 << 16];
+        while (true) {
+            const ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            } else if (n <= 0) {
+                return false;
+            }
+            input.append(buffer, n);
+            return true;
+        }
+    }
+
+    // takes the first whole line out of input
+    bool takeLine(std::string& input, std::string& line)
+    {
+        const std::size_t end = input.find('\n');
+        if (end == std::string::npos) {
+            return false;
+        }
+        line.assign(input, 0, end);
+        input.erase(0, end + 1);
+        return true;
+    }
+
+    // literals over variables up to numVars, ended by 0
+    bool parseLiterals(std::istream& in, const int numVars, std::vector<sat::Literal>& literals)
+    {
+        literals.clear();
+        int x;
+        while (in >> x) {
+            if (x == 0) {
+                return true;
+            } else if (x < -numVars || x > numVars) {
+                return false;
+            }
+            literals.push_back(sat::Literal(x));
+        }
+        return false;
+    }
+
+    std::string formatLiterals(const std::vector<sat::Literal>& literals)
+    {
+        std::string text;
+        for (const sat::Literal& t: literals) {
+            text += ' ' + std::to_string(t.rep());
+        }
+        return text + " 0";
+    }
+
+    // the cubes of a worker, read from the coordinator; anything to read
+    // while a cube is solved means the coordinator closed the connection,
+    // since it only answers results, so the solve is cancelled then
+    class Session : public sat::CubeSource
+    {
+    public:
+        Session(const int fd, const int numVars, sat::BaseSolver& solver):
+            fd(fd), numVars(numVars), solver(solver) {}
+        ~Session()
+        {
+            stopWatching();
+            ::close(fd);
+        }
+        Session(const Session&) = delete;
+        Session& operator=(const Session&) = delete;
+
+        virtual bool next(std::vector<sat::Literal>& cube,
+                std::vector<std::vector<sat::Literal>>& clauses);
+        virtual void finished(const sat::Result result, const std::vector<bool>& model,
+                const std::vector<std::vector<sat::Literal>>& learned);
+
+    private:
+        void startWatching();
+        void stopWatching();
+
+        const int fd;
+        const int numVars;
+        sat::BaseSolver& solver;
+        std::string input;
+        int id = -1;
+        bool done = false;
+        std::atomic<bool> watching{false};
+        std::thread watcher;
+    };
+
+    bool Session::next(std::vector<sat::Literal>& cube,
+            std::vector<std::vector<sat::Literal>>& clauses)
+    {
+        clauses.clear();
+        std::string line;
+        std::vector<sat::Literal> literals;
+        while (!done) {
+            while (!takeLine(input, line)) {
+                if (input.size() > MAX_LINE || !receiveSome(fd, input)) {
+                    return false;
+                }
+            }
+            std::istringstream in(line);
+            std::string command;
+            in >> command;
+            if (command == "clause" && parseLiterals(in, numVars, literals)) {
+                clauses.push_back(literals);
+            } else if (command == "cube" && in >> id && parseLiterals(in, numVars, cube)) {
+                startWatching();
+                return true;
+            } else {
+                throw std::runtime_error("Invalid message from the coordinator");
+            }
+        }
+        return false;
+    }
+
+    void Session::finished(const sat::Result result, const std::vector<bool>& model,
+            const std::vector<std::vector<sat::Literal>>& learned)
+    {
+        stopWatching();
+        std::string message;
+        for (const std::vector<sat::Literal>& clause: learned) {
+            message += "clause" + formatLiterals(clause) + '\n';
+        }
+        message += "result " + std::to_string(id);
+        if (result == sat::Result::Satisfiable) {
+            message += " sat";
+            // fresh variables are left out
+            for (int v = 1; v <= numVars; v++) {
+                message += ' ' + std::to_string(model[v - 1] ? v : -v);
+            }
+            message += " 0\n";
+        } else if (result == sat::Result::Unsatisfiable) {
+            message += " unsat\n";
+        } else {
+            // a limit of the worker was reached
+            message += " unknown\n";
+            done = true;
+        }
+        if (!sendAll(fd, message)) {
+            done = true;
+        }
+    }
+
+    void Session::startWatching()
+    {
+        watching = true;
+        watcher = std::thread([this] {
+            while (watching) {
+                pollfd event{fd, POLLIN, 0};
+                if (::poll(&event, 1, POLL_MILLISECONDS) > 0) {
+                    solver.cancel();
+                    return;
+                }
+            }
+        });
+    }
+
+    void Session::stopWatching()
+    {
+        if (watcher.joinable()) {
+            watching = false;
+            watcher.join();
+        }
+    }
+}
+
+sat::Coordinator::Coordinator(const Formula& formula, const std::string& address, const int depth):
+        formula(formula), key(canonicalKey(formula)), address(address)
+{
+    // the most frequent variables first, ties by lowest number
+    std::vector<int> occurrences(formula.numVariables() + 1, 0);
+    for (const Clause& clause: formula) {
+        for (const Literal& t: clause) {
+            occurrences[t.id()]++;
+        }
+    }
+    std::vector<int> vars;
+    for (int v = 1; v <= formula.numVariables(); v++) {
+        vars.push_back(v);
+    }
+    std::stable_sort(vars.begin(), vars.end(), [&](int v1, int v2) {
+        return occurrences[v1] > occurrences[v2];
+    });
+    vars.resize(std::min<std::size_t>(vars.size(), depth));
+    for (std::size_t signs = 0; signs < (std::size_t(1) << vars.size()); signs++) {
+        std::vector<Literal> cube;
+        for (std::size_t i = 0; i < vars.size(); i++) {
+            cube.push_back(Literal((signs >> i) & 1 ? -vars[i] : vars[i]));
+        }
+        pending.push_back(static_cast<int>(cubes.size()));
+        cubes.push_back(cube);
+    }
+    refuted.assign(cubes.size(), 0);
+    open = static_cast<int>(cubes.size());
+
+    if (isUnix(address)) {
+        const sockaddr_un local = unixAddress(address);
+        // left over by a coordinator before
+        struct stat status;
+        if (::lstat(local.sun_path, &status) == 0 && S_ISSOCK(status.st_mode)) {
+            ::unlink(local.sun_path);
+        }
+        listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (listener >= 0 && ::bind(listener, reinterpret_cast<const sockaddr*>(&local),
+                    sizeof(local)) == 0) {
+            socketPath = local.sun_path;
+            localAddress = address;
+        }
+    } else {
+        addrinfo* addresses = resolve(address, true);
+        for (addrinfo* a = addresses; a != nullptr && localAddress.empty(); a = a->ai_next) {
+            if (listener >= 0) {
+                ::close(listener);
+            }
+            listener = ::socket(a->ai_family, a->ai_socktype | SOCK_CLOEXEC, a->ai_protocol);
+            if (listener < 0) {
+                continue;
+            }
+            setOption(listener, SOL_SOCKET, SO_REUSEADDR, 1);
+            sockaddr_storage bound;
+            socklen_t size = sizeof(bound);
+            if (::bind(listener, a->ai_addr, a->ai_addrlen) == 0
+                    && ::getsockname(listener, reinterpret_cast<sockaddr*>(&bound), &size) == 0) {
+                // port 0 picks a free one, which local workers need to know
+                const int port = bound.ss_family == AF_INET6
+                    ? ntohs(reinterpret_cast<sockaddr_in6*>(&bound)->sin6_port)
+                    : ntohs(reinterpret_cast<sockaddr_in*>(&bound)->sin_port);
+                localAddress = "localhost:" + std::to_string(port);
+            }
+        }
+        ::freeaddrinfo(addresses);
+    }
+    if (localAddress.empty() || ::listen(listener, SOMAXCONN) != 0) {
+        if (listener >= 0) {
+            ::close(listener);
+        }
+        if (!socketPath.empty()) {
+            ::unlink(socketPath.c_str());
+        }
+        throw std::runtime_error("Cannot listen on " + address);
+    }
+}
+
+sat::Coordinator::~Coordinator()
+{
+    for (const Connection& connection: connections) {
+        if (connection.fd >= 0) {
+            ::close(connection.fd);
+        }
+    }
+    ::close(listener);
+    if (!socketPath.empty()) {
+        ::unlink(socketPath.c_str());
+    }
+    // local workers may not have connected yet, and have nothing left to do
+    for (pid_t child: children) {
+        ::kill(child, SIGKILL);
+        while (::waitpid(child, nullptr, 0) < 0 && errno == EINTR) {
+        }
+    }
+}
+
+void sat::Coordinator::spawn(const std::string& program, const std::string& fileName,
+        const int count)
+{
+    for (int i = 0; i < count; i++) {
+        const pid_t child = ::fork();
+        if (child < 0) {
+            throw std::runtime_error("Cannot start worker");
+        } else if (child == 0) {
+            ::execl(program.c_str(), program.c_str(), fileName.c_str(), "--worker",
+                    localAddress.c_str(), static_cast<char*>(nullptr));
+            ::_exit(127);
+        }
+        children.push_back(child);
+    }
+}
+
+void sat::Coordinator::solve(const int timeLimitSeconds, const bool verbose)
+{
+    Watchdog watchdog(budget, std::chrono::seconds(timeLimitSeconds));
+    std::vector<pollfd> events;
+    while (result == Result::Unknown && !budget.exhausted(0, 0)) {
+        if (terminate && terminate()) {
+            break;
+        }
+        events.assign(1, pollfd{listener, POLLIN, 0});
+        for (const Connection& connection: connections) {
+            events.push_back(pollfd{connection.fd, POLLIN, 0});
+        }
+        // interrupted by signals too
+        if (::poll(events.data(), events.size(), POLL_MILLISECONDS) <= 0) {
+            continue;
+        }
+        for (std::size_t i = 0; i < connections.size() && result == Result::Unknown; i++) {
+            if (events[i + 1].revents != 0 && !receive(connections[i])) {
+                drop(connections[i]);
+            }
+        }
+        // cubes of dropped workers go to idle ones
+        for (Connection& connection: connections) {
+            if (connection.fd >= 0 && connection.greeted && connection.cube < 0
+                    && !assign(connection)) {
+                drop(connection);
+            }
+        }
+        connections.erase(std::remove_if(connections.begin(), connections.end(),
+                    [](const Connection& connection) { return connection.fd < 0; }),
+                connections.end());
+        if (events[0].revents & POLLIN) {
+            accept();
+        }
+    }
+    printResult(verbose);
+}
+
+void sat::Coordinator::accept()
+{
+    const int fd = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    if (!isUnix(address)) {
+        keepAlive(fd);
+    }
+    timeval timeout{SEND_SECONDS, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    connections.push_back(Connection(fd));
+}
+
+// false if the worker is lost or does not follow the protocol
+bool sat::Coordinator::receive(Connection& connection)
+{
+    if (!receiveSome(connection.fd, connection.input)) {
+        return false;
+    }
+    std::string line;
+    while (result == Result::Unknown && takeLine(connection.input, line)) {
+        if (!handle(connection, line)) {
+            return false;
+        }
+    }
+    return connection.input.size() <= MAX_LINE;
+}
+
+bool sat::Coordinator::handle(Connection& connection, const std::string& line)
+{
+    std::istringstream in(line);
+    std::string command;
+    in >> command;
+    if (!connection.greeted) {
+        // a worker of another formula
+        std::string workerKey;
+        if (command != "hello" || !(in >> workerKey)) {
+            return false;
+        } else if (workerKey != key) {
+            std::cerr << "Rejected a worker of another formula" << std::endl;
+            return false;
+        }
+        connection.greeted = true;
+        workers++;
+        return assign(connection);
+    }
+    std::vector<Literal> literals;
+    if (command == "clause") {
+        if (!parseLiterals(in, formula.numVariables(), literals)) {
+            return false;
+        }
+        std::vector<int> indices;
+        for (const Literal& t: literals) {
+            indices.push_back(t.index());
+        }
+        std::sort(indices.begin(), indices.end());
+        if (literals.size() <= MAX_SHARED_SIZE && shared.size() < MAX_SHARED_CLAUSES
+                && sharedIndices.insert(indices).second) {
+            shared.push_back(literals);
+        }
+        return true;
+    }
+    int id;
+    std::string outcome;
+    if (command != "result" || !(in >> id >> outcome) || id != connection.cube) {
+        return false;
+    }
+    if (outcome == "unsat") {
+        connection.cube = -1;
+        refuted[id] = 1;
+        if (--open == 0) {
+            result = Result::Unsatisfiable;
+            return true;
+        }
+        return assign(connection);
+    } else if (outcome == "sat" && parseLiterals(in, formula.numVariables(), literals)) {
+        // values in the order of the variables, checked before they are trusted
+        std::vector<bool> values;
+        for (const Literal& t: literals) {
+            if (t.id() != static_cast<int>(values.size()) + 1) {
+                return false;
+            }
+            values.push_back(t.polarity());
+        }
+        if (!satisfies(formula, values)) {
+            return false;
+        }
+        connection.cube = -1;
+        model = std::move(values);
+        result = Result::Satisfiable;
+        return true;
+    }
+    // unknown too: the worker reached a limit and stops
+    return false;
+}
+
+// the next cube, with the clauses shared since the last one; an idle
+// worker waits for the cube of a lost one
+bool sat::Coordinator::assign(Connection& connection)
+{
+    if (pending.empty()) {
+        return true;
+    }
+    std::string message;
+    for (; connection.sent < shared.size(); connection.sent++) {
+        message += "clause" + formatLiterals(shared[connection.sent]) + '\n';
+    }
+    connection.cube = pending.front();
+    pending.pop_front();
+    message += "cube " + std::to_string(connection.cube) + formatLiterals(cubes[connection.cube]) + '\n';
+    return sendAll(connection.fd, message);
+}
+
+void sat::Coordinator::drop(Connection& connection)
+{
+    if (connection.cube >= 0 && !refuted[connection.cube]) {
+        pending.push_front(connection.cube);
+        reissued++;
+    }
+    connection.cube = -1;
+    ::close(connection.fd);
+    connection.fd = -1;
+}
+
+void sat::Coordinator::printResult(const bool verbose) const
+{
+    std::ostream& out = std::cout;
+    out << result << std::endl;
+    if (!verbose) {
+        return;
+    }
+    if (result == Result::Satisfiable) {
+        for (std::size_t i = 0; i < model.size(); i++) {
+            out << (model[i] ? "" : "-") << i + 1 << " ";
+        }
+        out << "0" << std::endl;
+    }
+    out << "Cubes: " << cubes.size() << ", refuted: " << cubes.size() - open
+        << ", workers: " << workers << ", reissued: " << reissued
+        << ", clauses shared: " << shared.size() << std::endl;
+}
+
+void sat::runWorker(const std::string& address, const std::string& key, const int numVars,
+        BaseSolver& solver, const int timeLimitSeconds)
+{
+    const int fd = connectTo(address);
+    Session session(fd, numVars, solver);
+    if (!sendAll(fd, "hello " + key + '\n')) {
+        throw std::runtime_error("Cannot send to " + address);
+    }
+    solver.solveCubes(session, timeLimitSeconds);
+}
@@ -0,0 +1,103 @@
+
+#ifndef SAT_DISTRIBUTED_H
+#define SAT_DISTRIBUTED_H
+
+#include "formula.h"
+#include "solver.h"
+#include "budget.h"
+#include <deque>
+#include <functional>
+#include <set>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+namespace sat
+{
+    // addresses are unix:path for a Unix socket, or host:port for TCP;
+    // messages are lines of text:
+    //   worker:      hello key
+    //   coordinator: clause literals 0, then cube id literals 0
+    //   worker:      clause literals 0, then result id sat values 0,
+    //                result id unsat or result id unknown
+    // the key, of canonicalKey, makes sure both read the same formula
+
+    // splits the formula into cubes over its most frequent variables, and
+    // hands them out to the workers that connect, one at a time; a cube of
+    // a worker lost is handed out again
+    class Coordinator
+    {
+    public:
+        // listens on address for workers; 2^depth cubes
+        Coordinator(const Formula& formula, const std::string& address, const int depth); // can throw
+        ~Coordinator();
+        Coordinator(const Coordinator&) = delete;
+        Coordinator& operator=(const Coordinator&) = delete;
+
+        // starts workers on this host, running program on fileName
+        void spawn(const std::string& program, const std::string& fileName, const int count); // can throw
+        // until a cube is satisfiable, every cube is unsatisfiable, or the
+        // time limit is reached; prints the result like the solver
+        void solve(const int timeLimitSeconds, const bool verbose);
+        // async-signal-safe, the solve stops with unknown
+        void cancel() noexcept { budget.stop(); }
+        // polled between events, and several times a second; once it
+        // returns true, the solve stops with unknown
+        void setTermination(std::function<bool()> terminate) { this->terminate = std::move(terminate); }
+        Result getResult() const { return result; }
+
+    private:
+        struct Connection
+        {
+            explicit Connection(const int fd): fd(fd) {}
+
+            int fd;
+            std::string input;
+            bool greeted = false;
+            int cube = -1;
+            // shared clauses sent to it so far
+            std::size_t sent = 0;
+        };
+
+        void accept();
+        bool receive(Connection& connection);
+        bool handle(Connection& connection, const std::string& line);
+        bool assign(Connection& connection);
+        void drop(Connection& connection);
+        void printResult(const bool verbose) const;
+
+        static const std::size_t MAX_SHARED_SIZE = 4;
+        static const std::size_t MAX_SHARED_CLAUSES = 100000;
+
+        const Formula& formula;
+        const std::string key;
+        std::string address;
+        // an address the workers spawned here can connect to
+        std::string localAddress;
+        std::string socketPath;
+        int listener = -1;
+        Budget budget;
+        std::function<bool()> terminate;
+        Result result = Result::Unknown;
+        std::vector<bool> model;
+
+        std::vector<std::vector<Literal>> cubes;
+        std::deque<int> pending;
+        std::vector<char> refuted;
+        int open;
+        std::vector<Connection> connections;
+        std::vector<pid_t> children;
+        std::vector<std::vector<Literal>> shared;
+        std::set<std::vector<int>> sharedIndices;
+        int workers = 0;
+        int reissued = 0;
+    };
+
+    // connects to the coordinator at address, and solves the cubes it sends,
+    // over variables up to numVars, until it closes the connection or the
+    // solver stops with unknown
+    void runWorker(const std::string& address, const std::string& key, const int numVars,
+            BaseSolver& solver, const int timeLimitSeconds); // can throw
+}
+
+#endif // SAT_DISTRIBUTED_H
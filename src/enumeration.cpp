@@ -0,0 +1,116 @@
+
+#include "solver.h"
+#include <algorithm>
+#include <ostream>
+
+template <class Config>
+void sat::Solver<Config>::setEnumeration(std::ostream& out, const std::vector<int>& projection)
+{
+    models = std::make_unique<ModelWriter>(out);
+    projected.assign(formula.numVariables() + 1, projection.empty());
+    for (int v: projection) {
+        projected.at(v) = 1;
+    }
+    projected[0] = 0;
+}
+
+// writes the cube of projected literals the original and blocking clauses
+// need, satisfying the others by the values of the variables not projected;
+// its blocking clause is added and made unit, or a conflict if it cannot be
+template <class Config>
+void sat::Solver<Config>::blockModel()
+{
+    std::vector<char> needed(formula.numVariables() + 1, 0);
+    // clauses with a single true literal first, then greedily
+    for (const bool single: {true, false}) {
+        int index = 0;
+        for (const Clause& clause: formula) {
+            if (index++ >= numOriginalClauses
+                    && addedClauses.find(&clause) == addedClauses.end()) {
+                continue;
+            }
+            const Literal* pick = nullptr;
+            int numTrue = 0;
+            bool satisfied = false;
+            for (const Literal& t: clause) {
+                if (!assignment.isTrue(t)) {
+                    continue;
+                }
+                numTrue++;
+                if (!projected[t.id()] || needed[t.id()]) {
+                    satisfied = true;
+                    break;
+                }
+                if (pick == nullptr) {
+                    pick = &t;
+                }
+            }
+            if (!satisfied && (!single || numTrue == 1)) {
+                needed[pick->id()] = 1;
+            }
+        }
+    }
+    std::vector<Literal> cube;
+    int numFree = 0;
+    for (int v = 1; v <= formula.numInputVariables(); v++) {
+        if (!projected[v]) {
+            continue;
+        }
+        if (needed[v]) {
+            cube.push_back(assignment.isTrue(Literal(v)) ? Literal(v) : Literal(-v));
+        } else {
+            numFree++;
+        }
+    }
+    models->write(cube, numFree);
+    if (cube.empty()) {
+        setUnsatisfiable();
+        return;
+    }
+
+    std::vector<Literal> literals;
+    for (const Literal& t: cube) {
+        literals.push_back(t.negate());
+    }
+    std::sort(literals.begin(), literals.end(), [this](const Literal& t1, const Literal& t2) {
+        return assignment.levelOf(t1) > assignment.levelOf(t2);
+    });
+    const int level = assignment.levelOf(literals[0]);
+    if (level == 0) {
+        setUnsatisfiable();
+        return;
+    }
+    const int assertionLevel = literals.size() > 1 ? assignment.levelOf(literals[1]) : 0;
+    Clause& clause = formula.addClause(Clause(literals));
+    addedClauses.insert(&clause);
+    if (clause.size() > 1) {
+        addToWatchList(clause.w1(), clause);
+        addToWatchList(clause.w2(), clause);
+    }
+    if (assertionLevel < level) {
+        backtrack(assertionLevel);
+        if (assignment.isFalse(clause[0])) {
+            markConflict(clause);
+        } else if (!assignment.isAssigned(clause[0])) {
+            assign(clause[0], clause.size() > 1 ? &clause : nullptr);
+        }
+    } else {
+        backtrack(level);
+        markConflict(clause);
+    }
+}
+
+namespace sat
+{
+    template void Solver<DefaultConfig<false, false>>::setEnumeration(std::ostream&, const std::vector<int>&);
+    template void Solver<DefaultConfig<false, false>>::blockModel();
+
+    template void Solver<DefaultConfig<false, true>>::setEnumeration(std::ostream&, const std::vector<int>&);
+    template void Solver<DefaultConfig<false, true>>::blockModel();
+
+    template void Solver<DefaultConfig<true, false>>::setEnumeration(std::ostream&, const std::vector<int>&);
+    template void Solver<DefaultConfig<true, false>>::blockModel();
+
+    template void Solver<DefaultConfig<true, true>>::setEnumeration(std::ostream&, const std::vector<int>&);
+    template void Solver<DefaultConfig<true, true>>::blockModel();
+}
@@ -1,7 +1,8 @@
 
 #include "formula.h"
+#include <iterator>
 
-sat::Formula::Formula(const int numVars): numVars(numVars)
+sat::Formula::Formula(const int numVars): numVars(numVars), numInputVars(numVars)
 {}
 
 int sat::Formula::numVariables() const
@@ -9,6 +10,16 @@ int sat::Formula::numVariables() const
     return numVars;
 }
 
+int sat::Formula::numInputVariables() const
+{
+    return numInputVars;
+}
+
+int sat::Formula::addVariable()
+{
+    return ++numVars;
+}
+
 int sat::Formula::numClauses() const
 {
     return clauses.size();
@@ -16,16 +27,52 @@ int sat::Formula::numClauses() const
 
 sat::Clause& sat::Formula::addClause(Clause&& clause)
 {
+    clauseMemory += clauseBytes(clause);
     clauses.push_back(std::make_unique<Clause>(std::move(clause)));
     return *clauses.back();
 }
 
 sat::Clause& sat::Formula::addClause(const Clause& clause)
 {
+    clauseMemory += clauseBytes(clause);
     clauses.push_back(std::make_unique<Clause>(clause));
     return *clauses.back();
 }
 
+void sat::Formula::append(Formula&& other)
+{
+    clauses.insert(clauses.end(), std::make_move_iterator(other.clauses.begin()),
+            std::make_move_iterator(other.clauses.end()));
+    clauseMemory += other.clauseMemory;
+    other.clauses.clear();
+    other.clauseMemory = 0;
+}
+
+std::size_t sat::Formula::memoryUsage() const noexcept
+{
+    return clauseMemory + clauses.capacity() * sizeof(std::unique_ptr<Clause>);
+}
+
+std::uint64_t sat::Formula::hash() const noexcept
+{
+    const std::uint64_t PRIME = 0x100000001b3ull;
+    std::uint64_t h = 0xcbf29ce484222325ull;
+    auto mix = [&](std::uint64_t x) {
+        for (int i = 0; i < 8; i++) {
+            h = (h ^ (x & 0xff)) * PRIME;
+            x >>= 8;
+        }
+    };
+    mix(numVars);
+    for (const std::unique_ptr<Clause>& clause: clauses) {
+        mix(clause->size());
+        for (const Literal& t: *clause) {
+            mix(t.index());
+        }
+    }
+    return h;
+}
+
 sat::Formula::iterator sat::Formula::begin()
 {
     return iterator(clauses.begin());
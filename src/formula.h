@@ -5,9 +5,18 @@
 #include "clause.h"
 #include <vector>
 #include <memory>
+#include <algorithm>
+#include <cstdint>
 
 namespace sat
 {
+    // a clause that may be falsified at the cost of its weight
+    struct SoftClause
+    {
+        std::vector<Literal> literals;
+        std::uint64_t weight;
+    };
+
     template <bool is_const = false>
     class Formula_iterator;
 
@@ -17,10 +26,26 @@ namespace sat
     public:
         explicit Formula(const int numVars);
         int numVariables() const;
+        // variables of the input, fresh ones are numbered after them
+        int numInputVariables() const;
+        // returns the fresh variable
+        int addVariable();
         int numClauses() const;
 
         Clause& addClause(Clause&& clause);
         Clause& addClause(const Clause& clause);
+        // moves the clauses of other, over the same variables, after these
+        void append(Formula&& other);
+        Clause& clause(const int i) { return *clauses[i]; }
+        const Clause& clause(const int i) const { return *clauses[i]; }
+        // removes the clauses from index first on for which remove(clause)
+        // is true, returns the number of removed clauses
+        template <class Predicate>
+        int removeClauses(const int first, Predicate remove);
+        // bytes held by the clauses, an upper bound
+        std::size_t memoryUsage() const noexcept;
+        // FNV-1a hash of the number of variables and the clauses in order
+        std::uint64_t hash() const noexcept;
 
         using iterator = Formula_iterator<>;
         using const_iterator = Formula_iterator<true>;
@@ -31,10 +56,36 @@ namespace sat
         const_iterator end() const;
 
     private:
+        static std::size_t clauseBytes(const Clause& clause) noexcept
+        {
+            return sizeof(std::unique_ptr<Clause>) + sizeof(Clause)
+                + clause.size() * sizeof(Literal);
+        }
+
         int numVars;
+        int numInputVars;
         std::vector<std::unique_ptr<Clause>> clauses;
+        std::size_t clauseMemory = 0;
     };
 
+    template <class Predicate>
+    int Formula::removeClauses(const int first, Predicate remove)
+    {
+        auto begin = clauses.begin() + first;
+        auto last = std::remove_if(begin, clauses.end(),
+                [&](const std::unique_ptr<Clause>& c) {
+                    if (remove(*c)) {
+                        clauseMemory -= clauseBytes(*c);
+                        return true;
+                    }
+                    return false;
+                });
+        const int removed = clauses.end() - last;
+        clauses.erase(last, clauses.end());
+        clauses.shrink_to_fit();
+        return removed;
+    }
+
     template <bool is_const, class Const, class NonConst>
     struct choose;
 
@@ -0,0 +1,285 @@
+
+#include "gauss.h"
+#include <utility>
+
+sat::Gauss::Gauss(const std::vector<Xor>& xors, const Assignment& assignment):
+    assignment(assignment), varColumn(assignment.total() + 1, -1)
+{
+    for (const Xor& x: xors) {
+        for (int v: x.vars) {
+            if (varColumn[v] < 0) {
+                varColumn[v] = numColumns++;
+                columnVar.push_back(v);
+            }
+        }
+    }
+    numWords = (numColumns + WORD_BITS - 1) / WORD_BITS;
+    matrix.assign(xors.size() * numWords, 0);
+    for (std::size_t r = 0; r < xors.size(); r++) {
+        for (int v: xors[r].vars) {
+            const int c = varColumn[v];
+            row(r)[c / WORD_BITS] ^= Word(1) << (c % WORD_BITS);
+        }
+        rhs.push_back(xors[r].rhs);
+    }
+    unassignedMask.assign(numWords, 0);
+    trueMask.assign(numWords, 0);
+    eliminate();
+    isPending.assign(numRows(), 0);
+    pivotRow.assign(numColumns, -1);
+    for (int r = 0; r < numRows(); r++) {
+        pivotRow[pivot[r]] = r;
+    }
+    secondWatch.assign(numRows(), -1);
+    watchers.resize(numColumns);
+}
+
+void sat::Gauss::eliminate()
+{
+    const int rows = numRows();
+    int r = 0;
+    for (int c = 0; c < numColumns && r < rows; c++) {
+        int p = r;
+        while (p < rows && !test(row(p), c)) {
+            p++;
+        }
+        if (p == rows) {
+            continue;
+        }
+        if (p != r) {
+            std::swap_ranges(row(p), row(p) + numWords, row(r));
+            std::swap(rhs[p], rhs[r]);
+        }
+        for (int q = 0; q < rows; q++) {
+            if (q != r && test(row(q), c)) {
+                xorRows(q, r);
+            }
+        }
+        pivot.push_back(c);
+        r++;
+    }
+    // the remaining rows are zero, 0 = 1 means there is no solution
+    for (int q = r; q < rows; q++) {
+        if (rhs[q]) {
+            isInconsistent = true;
+        }
+    }
+    matrix.resize(r * numWords);
+    rhs.resize(r);
+}
+
+void sat::Gauss::xorRows(const int target, const int source)
+{
+    Word* t = row(target);
+    const Word* s = row(source);
+    for (int w = 0; w < numWords; w++) {
+        t[w] ^= s[w];
+    }
+    rhs[target] ^= rhs[source];
+}
+
+void sat::Gauss::updateColumn(const int c)
+{
+    const Literal t(columnVar[c]);
+    const Word bit = Word(1) << (c % WORD_BITS);
+    Word& unassigned = unassignedMask[c / WORD_BITS];
+    Word& isTrue = trueMask[c / WORD_BITS];
+    if (assignment.isAssigned(t)) {
+        unassigned &= ~bit;
+        if (assignment.isTrue(t)) {
+            isTrue |= bit;
+        } else {
+            isTrue &= ~bit;
+        }
+    } else {
+        unassigned |= bit;
+        isTrue &= ~bit;
+    }
+}
+
+void sat::Gauss::schedule(const int r)
+{
+    if (!isPending[r]) {
+        isPending[r] = 1;
+        pending.push_back(r);
+    }
+}
+
+const sat::Clause* sat::Gauss::assigned(const Literal& t, std::vector<Implication>& implied)
+{
+    // variables added after construction are in no row
+    if (t.id() >= static_cast<int>(varColumn.size())) {
+        return nullptr;
+    }
+    const int c = varColumn[t.id()];
+    if (c < 0) {
+        return nullptr;
+    }
+    updateColumn(c);
+    assignedColumns.push_back(c);
+    if (pivotRow[c] >= 0) {
+        schedule(pivotRow[c]);
+    }
+    // rows that watch another column now are dropped from the list, and so
+    // are rows listed twice, pending after their first entry
+    std::vector<int>& rows = watchers[c];
+    std::size_t kept = 0;
+    for (int r: rows) {
+        if (secondWatch[r] == c && !isPending[r]) {
+            schedule(r);
+            rows[kept++] = r;
+        }
+    }
+    rows.resize(kept);
+    return processRows(implied);
+}
+
+void sat::Gauss::propagateAll(std::vector<Implication>& implied)
+{
+    for (int c = 0; c < numColumns; c++) {
+        updateColumn(c);
+    }
+    for (int r = 0; r < numRows(); r++) {
+        schedule(r);
+    }
+    // a falsified row is left to the clauses of its xor
+    processRows(implied);
+}
+
+void sat::Gauss::backtrack(const int level, std::vector<Implication>& implied)
+{
+    while (!clauseLevels.empty() && clauseLevels.back() > level) {
+        clauses.pop_back();
+        clauseLevels.pop_back();
+    }
+    while (!assignedColumns.empty()
+            && !assignment.isAssigned(Literal(columnVar[assignedColumns.back()]))) {
+        updateColumn(assignedColumns.back());
+        assignedColumns.pop_back();
+    }
+    // rows checked at or below level are as they were then: watched by two
+    // unassigned columns, or with every column assigned at or below it
+    while (!checkedRows.empty() && checkedRows.back().second > level) {
+        schedule(checkedRows.back().first);
+        checkedRows.pop_back();
+    }
+    for (int r: uncheckedRows) {
+        schedule(r);
+    }
+    uncheckedRows.clear();
+    // a falsified row is left to the clauses of its xor
+    processRows(implied);
+}
+
+const sat::Clause* sat::Gauss::processRows(std::vector<Implication>& implied)
+{
+    while (!pending.empty()) {
+        const int r = pending.back();
+        pending.pop_back();
+        isPending[r] = 0;
+        const Clause* conflict = check(r, implied);
+        if (conflict != nullptr) {
+            for (int q: pending) {
+                isPending[q] = 0;
+                uncheckedRows.push_back(q);
+            }
+            pending.clear();
+            return conflict;
+        }
+    }
+    return nullptr;
+}
+
+const sat::Clause* sat::Gauss::check(const int r, std::vector<Implication>& implied)
+{
+    // nothing is checked again at level 0, which is never backtracked below
+    if (assignment.currentLevel() > 0) {
+        checkedRows.push_back({r, assignment.currentLevel()});
+    }
+    Word* bits = row(r);
+    if (!test(unassignedMask.data(), pivot[r])) {
+        for (int w = 0; w < numWords; w++) {
+            const Word free = bits[w] & unassignedMask[w];
+            if (free != 0) {
+                changePivot(r, w * WORD_BITS + __builtin_ctzll(free));
+                break;
+            }
+        }
+    }
+    int numUnassigned = 0;
+    int parity = 0;
+    int second = -1;
+    for (int w = 0; w < numWords; w++) {
+        Word free = bits[w] & unassignedMask[w];
+        numUnassigned += __builtin_popcountll(free);
+        parity ^= __builtin_popcountll(bits[w] & trueMask[w]) & 1;
+        free &= ~(pivot[r] / WORD_BITS == w ? Word(1) << (pivot[r] % WORD_BITS) : 0);
+        if (second < 0 && free != 0) {
+            second = w * WORD_BITS + __builtin_ctzll(free);
+        }
+    }
+    const int current = secondWatch[r];
+    if (current >= 0 && current != pivot[r] && test(bits, current)
+            && test(unassignedMask.data(), current)) {
+        // the watch is kept
+        second = current;
+    }
+    watch(r, second);
+    if (numUnassigned >= 2) {
+        return nullptr;
+    }
+    if (numUnassigned == 0) {
+        return parity != rhs[r] ? &makeClause(r, nullptr) : nullptr;
+    }
+    // the pivot is the only unassigned column
+    const int v = columnVar[pivot[r]];
+    const Literal t((rhs[r] ^ parity) ? v : -v);
+    implied.push_back({t, &makeClause(r, &t)});
+    return nullptr;
+}
+
+void sat::Gauss::changePivot(const int r, const int c)
+{
+    // c is not a pivot column, so it only leaves the rows it is xored out of;
+    // their watches may have left them, so they are checked again
+    const int rows = numRows();
+    for (int q = 0; q < rows; q++) {
+        if (q != r && test(row(q), c)) {
+            xorRows(q, r);
+            schedule(q);
+        }
+    }
+    pivotRow[pivot[r]] = -1;
+    pivotRow[c] = r;
+    pivot[r] = c;
+}
+
+void sat::Gauss::watch(const int r, const int c)
+{
+    if (c != secondWatch[r] && c >= 0) {
+        watchers[c].push_back(r);
+    }
+    secondWatch[r] = c;
+}
+
+const sat::Clause& sat::Gauss::makeClause(const int r, const Literal* implied)
+{
+    // the row is a sum of xors, so it implies the clause that is falsified
+    // by the current values of its assigned variables
+    literals.clear();
+    if (implied != nullptr) {
+        literals.push_back(*implied);
+    }
+    const Word* bits = row(r);
+    for (int w = 0; w < numWords; w++) {
+        for (Word b = bits[w]; b != 0; b &= b - 1) {
+            const int v = columnVar[w * WORD_BITS + __builtin_ctzll(b)];
+            if (implied == nullptr || v != implied->id()) {
+                literals.push_back(Literal(assignment.isTrue(Literal(v)) ? -v : v));
+            }
+        }
+    }
+    clauses.emplace_back(literals);
+    clauseLevels.push_back(assignment.currentLevel());
+    return clauses.back();
+}
@@ -0,0 +1,96 @@
+
+#ifndef SAT_GAUSS_H
+#define SAT_GAUSS_H
+
+#include "xor.h"
+#include "clause.h"
+#include "assignment.h"
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace sat
+{
+    // Gauss-Jordan elimination over xor constraints, the matrix is kept in
+    // reduced row echelon form with bit rows packed in 64 bit words; a row
+    // whose pivot gets assigned moves its pivot to an unassigned column,
+    // rows with one unassigned column propagate, rows with none can conflict;
+    // a row is watched by its pivot and one more unassigned column, and is
+    // only checked when one of them is assigned
+    class Gauss
+    {
+    public:
+        struct Implication
+        {
+            Literal literal;
+            const Clause* reason;
+        };
+
+        Gauss(const std::vector<Xor>& xors, const Assignment& assignment);
+        // the xors contradict each other
+        bool inconsistent() const { return isInconsistent; }
+        int numRows() const { return static_cast<int>(rhs.size()); }
+
+        // after t is assigned, implied literals are appended to implied;
+        // returns the clause of a falsified row, or nullptr
+        const Clause* assigned(const Literal& t, std::vector<Implication>& implied);
+        // checks every row against the current assignment
+        void propagateAll(std::vector<Implication>& implied);
+        // after backtracking to level, the rows checked or changed above it
+        // are checked again
+        void backtrack(const int level, std::vector<Implication>& implied);
+
+    private:
+        using Word = std::uint64_t;
+        static const int WORD_BITS = 64;
+
+        Word* row(const int r) { return &matrix[r * numWords]; }
+        bool test(const Word* bits, const int c) const { return (bits[c / WORD_BITS] >> (c % WORD_BITS)) & 1; }
+        void updateColumn(const int c);
+        void xorRows(const int target, const int source);
+        void eliminate();
+        void schedule(const int r);
+        const Clause* processRows(std::vector<Implication>& implied);
+        const Clause* check(const int r, std::vector<Implication>& implied);
+        void changePivot(const int r, const int c);
+        void watch(const int r, const int c);
+        const Clause& makeClause(const int r, const Literal* implied);
+
+        const Assignment& assignment;
+        int numColumns = 0;
+        int numWords = 0;
+        bool isInconsistent = false;
+        std::vector<int> columnVar;
+        std::vector<int> varColumn;
+
+        std::vector<Word> matrix;
+        std::vector<char> rhs;
+        std::vector<int> pivot;
+        // columns by their current values
+        std::vector<Word> unassignedMask;
+        std::vector<Word> trueMask;
+
+        // the row of each pivot column, or -1
+        std::vector<int> pivotRow;
+        // the watch besides the pivot, -1 if the row has one unassigned
+        // column or none; rows watching a column, some of them no more
+        std::vector<int> secondWatch;
+        std::vector<std::vector<int>> watchers;
+        // columns assigned as seen here, in the order of the trail
+        std::vector<int> assignedColumns;
+        // rows checked, with the level they were checked at, and rows left
+        // unchecked by a conflict; all are checked again when backtracking
+        std::vector<std::pair<int, int>> checkedRows;
+        std::vector<int> uncheckedRows;
+
+        std::vector<int> pending;
+        std::vector<char> isPending;
+        // reasons and conflicts, released when backtracking below their level
+        std::deque<Clause> clauses;
+        std::deque<int> clauseLevels;
+        std::vector<Literal> literals;
+    };
+}
+
+#endif // SAT_GAUSS_H
@@ -0,0 +1,94 @@
+
+#include "solver.h"
+
+template <class Config>
+void sat::Solver<Config>::setHint(const std::vector<Literal>& literals)
+{
+    hint = literals;
+}
+
+template <class Config>
+void sat::Solver<Config>::seedHint()
+{
+    std::vector<double> activities(formula.numVariables() + 1, 0.0);
+    for (const Literal& t: hint) {
+        assignment.setSavedPhase(t.id(), t.polarity());
+        activities[t.id()] = 1.0;
+    }
+    decision.setActivities(activities);
+}
+
+// local search from the hint, before preprocessing costs anything; the
+// saved phases fill in variables left out of it
+template <class Config>
+void sat::Solver<Config>::repairHint()
+{
+    LocalSearch search(formula, formula.numClauses(), 0);
+    std::vector<bool> values(formula.numVariables() + 1);
+    for (int v = 1; v <= formula.numVariables(); v++) {
+        values[v] = assignment.savedPhase(v);
+    }
+    search.reset(values);
+    const bool found = search.run(LOCAL_SEARCH_FLIPS);
+    stats.flips += search.flips();
+    if (found) {
+        setSatisfiable(std::vector<bool>(search.best().begin() + 1, search.best().end()));
+    }
+}
+
+// decides the hinted literals, each one that leads to a conflict taken
+// back, then the saved phases, propagating after each; without a conflict
+// that is a model, otherwise backtracking saves the phases reached
+template <class Config>
+void sat::Solver<Config>::tryHint()
+{
+    unitPropagation();
+    if (hasConflict) {
+        setUnsatisfiable();
+        return;
+    }
+    if (models || optimizing || coreOut != nullptr) {
+        return;
+    }
+    for (const Literal& t: hint) {
+        if (!assignment.isAssigned(t)) {
+            const int level = assignment.currentLevel();
+            decide(t);
+            unitPropagation();
+            if (hasConflict) {
+                backtrack(level);
+            }
+        }
+    }
+    while (!hasConflict && !assignment.allAssigned()) {
+        decide(decision.pick(assignment));
+        unitPropagation();
+    }
+    if (!hasConflict) {
+        setSatisfiable(assignment.values());
+    }
+    backtrack(0);
+}
+
+namespace sat
+{
+    template void Solver<DefaultConfig<false, false>>::setHint(const std::vector<Literal>&);
+    template void Solver<DefaultConfig<false, false>>::seedHint();
+    template void Solver<DefaultConfig<false, false>>::repairHint();
+    template void Solver<DefaultConfig<false, false>>::tryHint();
+
+    template void Solver<DefaultConfig<false, true>>::setHint(const std::vector<Literal>&);
+    template void Solver<DefaultConfig<false, true>>::seedHint();
+    template void Solver<DefaultConfig<false, true>>::repairHint();
+    template void Solver<DefaultConfig<false, true>>::tryHint();
+
+    template void Solver<DefaultConfig<true, false>>::setHint(const std::vector<Literal>&);
+    template void Solver<DefaultConfig<true, false>>::seedHint();
+    template void Solver<DefaultConfig<true, false>>::repairHint();
+    template void Solver<DefaultConfig<true, false>>::tryHint();
+
+    template void Solver<DefaultConfig<true, true>>::setHint(const std::vector<Literal>&);
+    template void Solver<DefaultConfig<true, true>>::seedHint();
+    template void Solver<DefaultConfig<true, true>>::repairHint();
+    template void Solver<DefaultConfig<true, true>>::tryHint();
+}
@@ -6,22 +6,33 @@
 
 namespace sat
 {
+    // literals are stored as a dense index: 2*var for the positive
+    // and 2*var+1 for the negative literal
     class Literal
     {
     public:
-        explicit Literal(const int rep);
-        int id() const;
+        explicit Literal(const int rep) noexcept:
+            code(rep > 0 ? 2 * rep : -2 * rep + 1) {}
+        static Literal fromIndex(const int index) noexcept
+        {
+            Literal t;
+            t.code = index;
+            return t;
+        }
+
+        int id() const noexcept { return code >> 1; }
         // false means negated
-        bool polarity() const;
-        Literal negate() const;
-        bool evaluate(const bool value) const;
-        int rep() const;
-        bool operator==(const Literal& t) const;
+        bool polarity() const noexcept { return (code & 1) == 0; }
+        Literal negate() const noexcept { return fromIndex(code ^ 1); }
+        bool evaluate(const bool value) const noexcept { return polarity() == value; }
+        int rep() const noexcept { return polarity() ? id() : -id(); }
+        int index() const noexcept { return code; }
+        bool operator==(const Literal& t) const noexcept { return code == t.code; }
+        bool operator!=(const Literal& t) const noexcept { return code != t.code; }
 
     private:
-        Literal(const int varId, const bool varPolarity);
-        int var;
-        bool pol;
+        Literal() noexcept {}
+        int code;
     };
 
     std::ostream& operator<<(std::ostream& out, const sat::Literal& t);
@@ -32,9 +43,9 @@ namespace std
     template <>
     struct hash<sat::Literal>
     {
-        size_t operator()(const sat::Literal& t) const
+        size_t operator()(const sat::Literal& t) const noexcept
         {
-            return hash<int>()(t.rep());
+            return hash<int>()(t.index());
         }
     };
 }
@@ -0,0 +1,175 @@
+
+#include "localsearch.h"
+#include <cmath>
+
+sat::LocalSearch::LocalSearch(const Formula& formula, const int numClauses,
+        const std::uint64_t seed):
+    numVars(formula.numVariables()),
+    occurrences(2 * (formula.numVariables() + 1)),
+    breaks(formula.numVariables() + 1, 0),
+    rngState(seed * 0x9e3779b97f4a7c15ull + 1)
+{
+    for (int c = 0; c < numClauses; c++) {
+        clauseStart.push_back(literals.size());
+        for (const Literal& t: formula.clause(c)) {
+            literals.push_back(t);
+            occurrences[t.index()].push_back(c);
+        }
+    }
+    clauseStart.push_back(literals.size());
+    numTrue.resize(numClauses, 0);
+    trueSum.resize(numClauses, 0);
+    unsatisfiedPos.resize(numClauses, -1);
+
+    // cb = 2.38 and eps = 1, the polynomial break rule of ProbSAT
+    for (int b = 0; b <= MAX_BREAK; b++) {
+        breakProbability.push_back(std::pow(1.0 + b, -2.38));
+    }
+}
+
+void sat::LocalSearch::addClause(const std::vector<Literal>& clause)
+{
+    const int c = numTrue.size();
+    for (const Literal& t: clause) {
+        literals.push_back(t);
+        occurrences[t.index()].push_back(c);
+    }
+    clauseStart.push_back(literals.size());
+    numTrue.push_back(0);
+    trueSum.push_back(0);
+    unsatisfiedPos.push_back(-1);
+}
+
+void sat::LocalSearch::reset(const std::vector<bool>& initial)
+{
+    values = initial;
+    values.resize(numVars + 1, true);
+    numFlips = 0;
+    std::fill(breaks.begin(), breaks.end(), 0);
+    unsatisfied.clear();
+    const int numClauses = numTrue.size();
+    for (int c = 0; c < numClauses; c++) {
+        numTrue[c] = 0;
+        trueSum[c] = 0;
+        unsatisfiedPos[c] = -1;
+        for (std::size_t i = clauseStart[c]; i < clauseStart[c+1]; i++) {
+            const Literal& t = literals[i];
+            if (t.evaluate(values[t.id()])) {
+                numTrue[c]++;
+                trueSum[c] += t.id();
+            }
+        }
+        if (numTrue[c] == 0) {
+            addUnsatisfied(c);
+        } else if (numTrue[c] == 1) {
+            breaks[trueSum[c]]++;
+        }
+    }
+    bestValues = values;
+    bestNumUnsatisfied = numUnsatisfied();
+}
+
+bool sat::LocalSearch::run(const std::uint64_t maxFlips)
+{
+    for (std::uint64_t i = 0; i < maxFlips && !unsatisfied.empty(); i++) {
+        const int c = unsatisfied[nextRandom() % unsatisfied.size()];
+        flip(pickVariable(c));
+        if (numUnsatisfied() < bestNumUnsatisfied) {
+            bestNumUnsatisfied = numUnsatisfied();
+            bestValues = values;
+        }
+    }
+    return unsatisfied.empty();
+}
+
+std::size_t sat::LocalSearch::memoryUsage() const noexcept
+{
+    std::size_t bytes = literals.capacity() * sizeof(Literal)
+        + clauseStart.capacity() * sizeof(std::size_t)
+        + occurrences.capacity() * sizeof(std::vector<int>)
+        + (values.capacity() + bestValues.capacity()) / 8
+        + (numTrue.capacity() + breaks.capacity() + unsatisfied.capacity()
+                + unsatisfiedPos.capacity()) * sizeof(int)
+        + trueSum.capacity() * sizeof(unsigned int);
+    for (const std::vector<int>& clauses: occurrences) {
+        bytes += clauses.capacity() * sizeof(int);
+    }
+    return bytes;
+}
+
+int sat::LocalSearch::pickVariable(const int clause)
+{
+    // every literal of an unsatisfied clause is false, flipping its variable
+    // breaks the clauses where its true complement is the only true literal
+    const std::size_t begin = clauseStart[clause], end = clauseStart[clause+1];
+    scores.clear();
+    double sum = 0;
+    for (std::size_t i = begin; i < end; i++) {
+        const int b = breaks[literals[i].id()];
+        sum += breakProbability[b < MAX_BREAK ? b : MAX_BREAK];
+        scores.push_back(sum);
+    }
+    const double r = nextUniform() * sum;
+    std::size_t i = 0;
+    while (i + 1 < scores.size() && scores[i] <= r) {
+        i++;
+    }
+    return literals[begin + i].id();
+}
+
+void sat::LocalSearch::flip(const int var)
+{
+    numFlips++;
+    values[var] = !values[var];
+    const Literal made(values[var] ? var : -var);
+    for (int c: occurrences[made.index()]) {
+        numTrue[c]++;
+        trueSum[c] += var;
+        if (numTrue[c] == 1) {
+            removeUnsatisfied(c);
+            breaks[var]++;
+        } else if (numTrue[c] == 2) {
+            breaks[trueSum[c] - var]--;
+        }
+    }
+    for (int c: occurrences[made.negate().index()]) {
+        numTrue[c]--;
+        trueSum[c] -= var;
+        if (numTrue[c] == 0) {
+            addUnsatisfied(c);
+            breaks[var]--;
+        } else if (numTrue[c] == 1) {
+            breaks[trueSum[c]]++;
+        }
+    }
+}
+
+void sat::LocalSearch::addUnsatisfied(const int clause)
+{
+    unsatisfiedPos[clause] = unsatisfied.size();
+    unsatisfied.push_back(clause);
+}
+
+void sat::LocalSearch::removeUnsatisfied(const int clause)
+{
+    const int pos = unsatisfiedPos[clause];
+    const int last = unsatisfied.back();
+    unsatisfied[pos] = last;
+    unsatisfiedPos[last] = pos;
+    unsatisfied.pop_back();
+    unsatisfiedPos[clause] = -1;
+}
+
+std::uint64_t sat::LocalSearch::nextRandom()
+{
+    // xorshift64*
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return rngState * 0x2545f4914f6cdd1dull;
+}
+
+double sat::LocalSearch::nextUniform()
+{
+    return (nextRandom() >> 11) * (1.0 / 9007199254740992.0);
+}
@@ -0,0 +1,71 @@
+
+#ifndef SAT_LOCALSEARCH_H
+#define SAT_LOCALSEARCH_H
+
+#include "formula.h"
+#include "literal.h"
+#include <cstdint>
+#include <vector>
+
+namespace sat
+{
+    // ProbSAT stochastic local search over the clauses of a formula;
+    // break counts and the set of unsatisfied clauses are kept incrementally
+    class LocalSearch
+    {
+    public:
+        // over the first numClauses clauses of the formula
+        LocalSearch(const Formula& formula, const int numClauses, const std::uint64_t seed);
+        // a clause besides those of the formula, added before reset
+        void addClause(const std::vector<Literal>& clause);
+        // starts from values indexed by variable, index 0 is unused; may be
+        // called again to search anew from other values
+        void reset(const std::vector<bool>& values);
+        // flips at most maxFlips times, true if all clauses are satisfied
+        bool run(const std::uint64_t maxFlips);
+        int numUnsatisfied() const { return static_cast<int>(unsatisfied.size()); }
+        // values with the fewest unsatisfied clauses since reset
+        const std::vector<bool>& best() const { return bestValues; }
+        int bestUnsatisfied() const { return bestNumUnsatisfied; }
+        // since reset
+        std::uint64_t flips() const { return numFlips; }
+        int numVariables() const { return numVars; }
+        std::size_t memoryUsage() const noexcept;
+
+    private:
+        static const int MAX_BREAK = 64;
+
+        void flip(const int var);
+        int pickVariable(const int clause);
+        void addUnsatisfied(const int clause);
+        void removeUnsatisfied(const int clause);
+        std::uint64_t nextRandom();
+        double nextUniform();
+
+        int numVars;
+        // clause c has the literals in [clauseStart[c], clauseStart[c+1])
+        std::vector<Literal> literals;
+        std::vector<std::size_t> clauseStart;
+        // clause indices, indexed by Literal::index()
+        std::vector<std::vector<int>> occurrences;
+
+        std::vector<bool> values;
+        std::vector<int> numTrue;
+        // sum of the true variables of a clause, the only true
+        // variable of the clause when numTrue is 1
+        std::vector<unsigned int> trueSum;
+        std::vector<int> breaks;
+        std::vector<int> unsatisfied;
+        std::vector<int> unsatisfiedPos;
+
+        std::vector<bool> bestValues;
+        int bestNumUnsatisfied = 0;
+        std::uint64_t numFlips = 0;
+        std::uint64_t rngState;
+        // ProbSAT polynomial break probability by break count
+        std::vector<double> breakProbability;
+        std::vector<double> scores;
+    };
+}
+
+#endif // SAT_LOCALSEARCH_H
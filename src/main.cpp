@@ -1,24 +1,121 @@
 
 #include "solver.h"
 #include "parser.h"
+#include "proof.h"
+#include "symmetry.h"
+#include "budget.h"
+#include "cache.h"
+#include "distributed.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
 #include <iostream>
+#include <climits>
+#include <cstdlib>
 #include <signal.h>
 #include <unistd.h>
 
-sat::Solver* currSolver = nullptr;
+// set by signals, and polled by the solve, which stops with unknown then
+static std::atomic<bool> interrupted{false};
 
-static void signalHandler(int signal)
+static void signalHandler(int /*signal*/)
 {
-    if (currSolver != nullptr) {
-        currSolver->cancel();
+    interrupted = true;
+}
+
+// a positive decimal number, false if invalid
+static bool parseCount(const std::string& text, std::uint64_t& count)
+{
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    try {
+        count = std::stoull(text);
+    } catch (const std::out_of_range& e) {
+        return false;
+    }
+    return count > 0;
+}
+
+// comma separated variables and ranges like 3-7, empty if invalid
+static std::vector<int> parseVariables(const std::string& list)
+{
+    std::vector<int> vars;
+    std::istringstream in(list);
+    std::string item;
+    try {
+        while (std::getline(in, item, ',')) {
+            const std::size_t dash = item.find('-');
+            const int first = std::stoi(item.substr(0, dash));
+            const int last = dash == std::string::npos ? first : std::stoi(item.substr(dash + 1));
+            if (first <= 0 || last < first) {
+                return std::vector<int>();
+            }
+            for (int v = first; v <= last; v++) {
+                vars.push_back(v);
+            }
+        }
+    } catch (const std::logic_error& e) {
+        return std::vector<int>();
     }
+    return vars;
 }
 
+// prints a cached result like the solver prints its own
+static void printCached(const sat::ResultCache::Entry& entry, const std::string& key,
+        const bool verbose)
+{
+    std::cout << (entry.satisfiable ? sat::Result::Satisfiable : sat::Result::Unsatisfiable)
+              << std::endl;
+    if (!verbose) {
+        return;
+    }
+    if (entry.satisfiable) {
+        for (std::size_t i = 0; i < entry.model.size(); i++) {
+            std::cout << (entry.model[i] ? "" : "-") << i + 1 << " ";
+        }
+        std::cout << "0" << std::endl;
+    }
+    std::cout << "Cached result " << key;
+    if (!entry.proof.empty()) {
+        std::cout << ", proof " << entry.proof;
+    }
+    std::cout << std::endl;
+}
+
+static const std::uint64_t MAX_SPAWN = 1024;
+// megabytes whose bytes fit a size_t
+static const std::uint64_t MAX_MEMORY_LIMIT = SIZE_MAX >> 20;
+static const std::uint64_t MAX_CUBE_DEPTH = 20;
+static const int DEFAULT_CUBE_DEPTH = 6;
+
 void usage(char * argv0)
 {
     std::cerr << argv0 << " <filename> "
               << "[--time timeLimitSeconds] "
-              << "[--verbose]"
+              << "[--cpu-time seconds] "
+              << "[--conflicts n] "
+              << "[--props n] "
+              << "[--verbose] "
+              << "[--mem-limit megabytes] "
+              << "[--local-search] "
+              << "[--no-symmetry] "
+              << "[--all [--project vars]] "
+              << "[--checkpoint file] "
+              << "[--resume file] "
+              << "[--cache file] "
+              << "[--coordinator address [--spawn n] [--cube-depth d]] "
+              << "[--worker address] "
+              << "[--core file [--minimize-core]] "
+              << "[--hint file] "
+              << "[--backbone] "
+              << "[--reorder] "
+              << "[--proof proofFile [--proof-text]]"
               << std::endl;
 }
 
@@ -33,6 +130,28 @@ int main(int argc, char * argv[])
     bool timer = false;
     bool verbose = false;
     char * fileName = nullptr;
+    std::uint64_t memoryLimit = 0;
+    bool localSearchOnly = false;
+    bool symmetry = true;
+    bool allModels = false;
+    std::uint64_t cpuTimeLimit = 0;
+    std::uint64_t conflictLimit = 0;
+    std::uint64_t propagationLimit = 0;
+    std::vector<int> projection;
+    char * proofFileName = nullptr;
+    bool proofText = false;
+    char * checkpointFileName = nullptr;
+    char * resumeFileName = nullptr;
+    char * cacheFileName = nullptr;
+    char * coordinatorAddress = nullptr;
+    char * workerAddress = nullptr;
+    std::uint64_t spawnCount = 0;
+    std::uint64_t cubeDepth = 0;
+    char * coreFileName = nullptr;
+    bool minimizeCore = false;
+    char * hintFileName = nullptr;
+    bool backbone = false;
+    bool reorder = false;
     bool error = false;
     for (int i = 1; i < argc; i++) {
         if ("--time"s == argv[i]) {
@@ -48,8 +167,114 @@ int main(int argc, char * argv[])
                     break;
                 }
             }
+        } else if ("--cpu-time"s == argv[i]) {
+            if (cpuTimeLimit > 0 || ++i >= argc || !parseCount(argv[i], cpuTimeLimit)
+                    || cpuTimeLimit > static_cast<std::uint64_t>(INT32_MAX)) {
+                error = true;
+                break;
+            }
+        } else if ("--conflicts"s == argv[i]) {
+            if (conflictLimit > 0 || ++i >= argc || !parseCount(argv[i], conflictLimit)) {
+                error = true;
+                break;
+            }
+        } else if ("--props"s == argv[i]) {
+            if (propagationLimit > 0 || ++i >= argc || !parseCount(argv[i], propagationLimit)) {
+                error = true;
+                break;
+            }
         } else if ("--verbose"s == argv[i]) {
             verbose = true;
+        } else if ("--local-search"s == argv[i]) {
+            localSearchOnly = true;
+        } else if ("--no-symmetry"s == argv[i]) {
+            symmetry = false;
+        } else if ("--all"s == argv[i]) {
+            allModels = true;
+        } else if ("--project"s == argv[i]) {
+            if (!projection.empty() || ++i >= argc) {
+                error = true;
+                break;
+            }
+            projection = parseVariables(argv[i]);
+            if (projection.empty()) {
+                error = true;
+                break;
+            }
+        } else if ("--mem-limit"s == argv[i]) {
+            if (memoryLimit > 0 || ++i >= argc || !parseCount(argv[i], memoryLimit)
+                    || memoryLimit > MAX_MEMORY_LIMIT) {
+                error = true;
+                break;
+            }
+        } else if ("--proof"s == argv[i]) {
+            if (proofFileName != nullptr || ++i >= argc) {
+                error = true;
+                break;
+            }
+            proofFileName = argv[i];
+        } else if ("--proof-text"s == argv[i]) {
+            proofText = true;
+        } else if ("--checkpoint"s == argv[i]) {
+            if (checkpointFileName != nullptr || ++i >= argc) {
+                error = true;
+                break;
+            }
+            checkpointFileName = argv[i];
+        } else if ("--resume"s == argv[i]) {
+            if (resumeFileName != nullptr || ++i >= argc) {
+                error = true;
+                break;
+            }
+            resumeFileName = argv[i];
+        } else if ("--cache"s == argv[i]) {
+            if (cacheFileName != nullptr || ++i >= argc) {
+                error = true;
+                break;
+            }
+            cacheFileName = argv[i];
+        } else if ("--coordinator"s == argv[i]) {
+            if (coordinatorAddress != nullptr || ++i >= argc) {
+                error = true;
+                break;
+            }
+            coordinatorAddress = argv[i];
+        } else if ("--worker"s == argv[i]) {
+            if (workerAddress != nullptr || ++i >= argc) {
+                error = true;
+                break;
+            }
+            workerAddress = argv[i];
+        } else if ("--spawn"s == argv[i]) {
+            if (spawnCount > 0 || ++i >= argc || !parseCount(argv[i], spawnCount)
+                    || spawnCount > MAX_SPAWN) {
+                error = true;
+                break;
+            }
+        } else if ("--cube-depth"s == argv[i]) {
+            if (cubeDepth > 0 || ++i >= argc || !parseCount(argv[i], cubeDepth)
+                    || cubeDepth > MAX_CUBE_DEPTH) {
+                error = true;
+                break;
+            }
+        } else if ("--core"s == argv[i]) {
+            if (coreFileName != nullptr || ++i >= argc) {
+                error = true;
+                break;
+            }
+            coreFileName = argv[i];
+        } else if ("--minimize-core"s == argv[i]) {
+            minimizeCore = true;
+        } else if ("--hint"s == argv[i]) {
+            if (hintFileName != nullptr || ++i >= argc) {
+                error = true;
+                break;
+            }
+            hintFileName = argv[i];
+        } else if ("--backbone"s == argv[i]) {
+            backbone = true;
+        } else if ("--reorder"s == argv[i]) {
+            reorder = true;
         } else if (fileName == nullptr){
             fileName = argv[i];
         } else {
@@ -57,25 +282,206 @@ int main(int argc, char * argv[])
             break;
         }
     }
-    if (error || fileName == nullptr) {
+    // enumeration adds clauses that are not implied, and needs CDCL; so do
+    // checkpoints, and resumed clauses are not proof steps
+    const bool checkpoints = checkpointFileName != nullptr || resumeFileName != nullptr;
+    // the coordinator does not solve, workers only solve under cubes
+    const bool distributed = coordinatorAddress != nullptr || workerAddress != nullptr;
+    if (error || fileName == nullptr || (proofText && proofFileName == nullptr)
+            || (!projection.empty() && !allModels)
+            || (allModels && (proofFileName != nullptr || localSearchOnly))
+            || (checkpoints && (allModels || localSearchOnly))
+            || (cacheFileName != nullptr && allModels)
+            || (resumeFileName != nullptr && proofFileName != nullptr)
+            || (coordinatorAddress != nullptr && workerAddress != nullptr)
+            || ((spawnCount > 0 || cubeDepth > 0) && coordinatorAddress == nullptr)
+            || (distributed && (allModels || localSearchOnly || proofFileName != nullptr
+                    || checkpoints || cacheFileName != nullptr))
+            || (coordinatorAddress != nullptr && (conflictLimit > 0 || propagationLimit > 0
+                    || memoryLimit > 0))
+            || (minimizeCore && coreFileName == nullptr)
+            || (coreFileName != nullptr && (allModels || localSearchOnly || proofFileName != nullptr
+                    || checkpoints || cacheFileName != nullptr || distributed))
+            || (hintFileName != nullptr && distributed)
+            || (backbone && (allModels || localSearchOnly || proofFileName != nullptr || checkpoints
+                    || cacheFileName != nullptr || distributed || coreFileName != nullptr))
+            || (reorder && (allModels || proofFileName != nullptr || checkpoints || distributed
+                    || coreFileName != nullptr || backbone))) {
         usage(argv[0]);
         return EXIT_FAILURE;
     }
 
-    // handle cancellation
-    struct sigaction newAction, oldAction;
+    // handle cancellation, and the cpu time limit
+    struct sigaction newAction;
     newAction.sa_handler = signalHandler;
     sigemptyset(&newAction.sa_mask);
     newAction.sa_flags = 0;
-    sigaction(SIGINT, &newAction, &oldAction);
+    for (int signal: {SIGINT, SIGTERM, SIGXCPU}) {
+        sigaction(signal, &newAction, nullptr);
+    }
 
+    std::unique_ptr<sat::Proof> proof;
+    if (proofFileName != nullptr) {
+        try {
+            proof = std::make_unique<sat::Proof>(proofFileName, !proofText);
+        } catch (const std::invalid_argument& e) {
+            std::cerr << "Error opening proof file `" << proofFileName << "': "
+                      << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::unique_ptr<sat::BaseSolver> solver;
     try {
-        sat::Solver solver(sat::Parser(fileName).getFormula());
-        currSolver = &solver;
-        solver.solve(timeLimitSeconds, verbose);
+        sat::Parser parser(fileName);
+        sat::Formula formula = parser.getFormula();
+        // soft clauses are optimized by adding clauses that are not implied,
+        // over all models, which needs CDCL
+        if (parser.isWeighted() && (proof != nullptr || allModels || localSearchOnly || checkpoints
+                    || cacheFileName != nullptr || distributed || coreFileName != nullptr || backbone
+                    || reorder)) {
+            std::cerr << "WCNF input cannot be combined with --proof, --all, --local-search, "
+                      << "--checkpoint, --resume, --cache, --coordinator, --worker, --core, "
+                      << "--backbone or --reorder"
+                      << std::endl;
+            return EXIT_FAILURE;
+        }
+        for (int v: projection) {
+            if (v > formula.numVariables()) {
+                std::cerr << "Projected variable " << v << " is not in the formula" << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        std::vector<sat::Literal> hint;
+        if (hintFileName != nullptr) {
+            hint = sat::readHint(hintFileName);
+            for (const sat::Literal& t: hint) {
+                if (t.id() > formula.numVariables()) {
+                    std::cerr << "Hinted variable " << t.id() << " is not in the formula" << std::endl;
+                    return EXIT_FAILURE;
+                }
+            }
+        }
+        if (coordinatorAddress != nullptr) {
+            sat::Coordinator coordinator(formula, coordinatorAddress,
+                    cubeDepth > 0 ? static_cast<int>(cubeDepth) : DEFAULT_CUBE_DEPTH);
+            coordinator.setTermination([] { return interrupted.load(); });
+            // the local workers run this program
+            char program[PATH_MAX] = "";
+            if (spawnCount > 0 && realpath("/proc/self/exe", program) == nullptr) {
+                throw std::runtime_error("Cannot find the program to spawn workers");
+            }
+            coordinator.spawn(program, fileName, static_cast<int>(spawnCount));
+            if (cpuTimeLimit > 0) {
+                sat::limitCpuTime(cpuTimeLimit);
+            }
+            coordinator.solve(timeLimitSeconds, verbose);
+            return EXIT_SUCCESS;
+        }
+        // results are looked up before any preprocessing; a proof can only
+        // be written by solving, a cached model is checked before it is used
+        std::unique_ptr<sat::ResultCache> cache;
+        std::string cacheKey;
+        const int numVars = formula.numVariables();
+        if (cacheFileName != nullptr) {
+            cache = std::make_unique<sat::ResultCache>(cacheFileName);
+            cacheKey = sat::canonicalKey(formula);
+            sat::ResultCache::Entry entry;
+            if (proof == nullptr && cache->lookup(cacheKey, entry)
+                    && (!entry.satisfiable || sat::satisfies(formula, entry.model))) {
+                printCached(entry, cacheKey, verbose);
+                return EXIT_SUCCESS;
+            }
+        }
+        // the coordinator checks that workers read the same formula
+        const std::string workerKey = workerAddress != nullptr ? sat::canonicalKey(formula) : "";
+        // symmetry breaking clauses are not implied by the formula, so they
+        // cannot be part of a proof, nor be shared by workers, and they
+        // leave out models; symmetries of the hard clauses need not preserve
+        // the soft ones; the symmetries found when stopped by the time limit
+        // vary, checkpoints need the same formula, and cores are of input
+        // clauses; a hinted model may be one of those left out, and a
+        // backbone is of all of them
+        // the time limit counts from here, the search for symmetries is
+        // part of the solve
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeLimitSeconds);
+        auto stopped = [timeLimitSeconds, deadline] {
+            return interrupted.load()
+                || (timeLimitSeconds > 0 && std::chrono::steady_clock::now() >= deadline);
+        };
+        if (symmetry && proof == nullptr && !allModels && !parser.isWeighted() && !checkpoints
+                && !distributed && coreFileName == nullptr && hint.empty() && !backbone) {
+            sat::breakSymmetries(formula, sat::findSymmetries(formula, stopped));
+        }
+        // statistics are only counted where they are printed or limited
+        solver = sat::makeSolver(std::move(formula),
+                proof != nullptr, verbose || memoryLimit > 0 || propagationLimit > 0);
+        solver->setTermination(stopped);
+        if (conflictLimit > 0) {
+            solver->setConflictLimit(conflictLimit);
+        }
+        if (propagationLimit > 0) {
+            solver->setPropagationLimit(propagationLimit);
+        }
+        if (cpuTimeLimit > 0) {
+            sat::limitCpuTime(cpuTimeLimit);
+        }
+        solver->setProof(proof.get());
+        solver->setMemoryLimit(memoryLimit);
+        solver->setLocalSearchOnly(localSearchOnly);
+        if (allModels) {
+            solver->setEnumeration(std::cout, projection);
+        }
+        if (parser.isWeighted()) {
+            solver->setSoftClauses(parser.getSoftClauses());
+        }
+        if (checkpointFileName != nullptr) {
+            solver->setCheckpoint(checkpointFileName);
+        }
+        if (resumeFileName != nullptr) {
+            solver->resume(resumeFileName);
+        }
+        if (!hint.empty()) {
+            solver->setHint(hint);
+        }
+        std::ofstream coreFile;
+        if (coreFileName != nullptr) {
+            coreFile.open(coreFileName);
+            if (!coreFile) {
+                throw std::runtime_error("Cannot open core file "s + coreFileName);
+            }
+            solver->setCore(coreFile, minimizeCore);
+        }
+        if (backbone) {
+            solver->setBackbone(std::cout);
+        }
+        solver->setReordering(reorder);
+        if (workerAddress != nullptr) {
+            sat::runWorker(workerAddress, workerKey, numVars, *solver, timeLimitSeconds);
+            return EXIT_SUCCESS;
+        }
+        solver->solve(timeLimitSeconds, verbose);
+        if (cache && solver->getResult() != sat::Result::Unknown) {
+            sat::ResultCache::Entry entry{solver->getResult() == sat::Result::Satisfiable,
+                std::vector<bool>(), ""};
+            if (entry.satisfiable) {
+                // fresh variables of symmetry breaking are left out
+                const std::vector<bool>& model = solver->getModel();
+                entry.model.assign(model.begin(), model.begin() + numVars);
+            } else if (proof != nullptr) {
+                char path[PATH_MAX];
+                if (realpath(proofFileName, path) != nullptr) {
+                    entry.proof = path;
+                }
+            }
+            cache->store(cacheKey, entry);
+        }
     } catch (const std::invalid_argument& e) {
         std::cerr << "Error parsing DIMACS file `" << fileName << "': "
                   << e.what() << std::endl;
+    } catch (const std::runtime_error& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
     }
     return EXIT_SUCCESS;
 }
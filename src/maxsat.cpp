@@ -0,0 +1,185 @@
+
+#include "solver.h"
+#include <algorithm>
+#include <limits>
+#include <ostream>
+
+template <class Config>
+void sat::Solver<Config>::setSoftClauses(std::vector<SoftClause>&& clauses)
+{
+    optimizing = true;
+    softClauses = std::move(clauses);
+}
+
+template <class Config>
+std::uint64_t sat::Solver<Config>::cost(const std::vector<bool>& values) const
+{
+    std::uint64_t total = 0;
+    for (const SoftClause& clause: softClauses) {
+        if (std::none_of(clause.literals.begin(), clause.literals.end(),
+                    [&](const Literal& t) { return values[t.id() - 1] == t.polarity(); })) {
+            total += clause.weight;
+        }
+    }
+    return total;
+}
+
+// stratified by weight: only assumptions weighing at least the threshold
+// are made, and a model lowers it to the next weight; models are upper
+// bounds, cores lower bounds, and a model under every assumption is optimal
+template <class Config>
+void sat::Solver<Config>::optimize()
+{
+    // bounds are only printed by solve
+    std::ostream none(nullptr);
+    std::ostream& out = output != nullptr ? *output : none;
+    std::uint64_t lowerBound = 0;
+    for (const SoftClause& clause: softClauses) {
+        Literal t(0);
+        if (clause.literals.empty()) {
+            lowerBound += clause.weight;
+            continue;
+        } else if (clause.literals.size() == 1) {
+            t = clause.literals[0];
+        } else {
+            // the relaxation variable is true when the clause is falsified
+            t = Literal(-newVariable());
+            std::vector<Literal> literals(clause.literals);
+            literals.push_back(t.negate());
+            addClause(literals);
+        }
+        if (softWeights[t] == 0) {
+            softLiterals.push_back(t);
+        }
+        softWeights[t] += clause.weight;
+    }
+    if (lowerBound > 0) {
+        out << "c lower bound " << lowerBound << std::endl;
+    }
+    std::vector<bool> best;
+    bool hasModel = false;
+    Result optimum = Result::Unknown;
+    std::uint64_t threshold = std::numeric_limits<std::uint64_t>::max();
+    while (!stopped()) {
+        // the threshold is the highest weight below it, when the last
+        // search was not stopped by a core
+        if (result != Result::Unsatisfiable) {
+            std::uint64_t next = 0;
+            for (const Literal& t: softLiterals) {
+                if (softWeights.at(t) < threshold) {
+                    next = std::max(next, softWeights.at(t));
+                }
+            }
+            if (next == 0 && hasModel) {
+                optimum = Result::Satisfiable;
+                break;
+            }
+            threshold = std::max(next, std::uint64_t(1));
+        }
+        assumptions.clear();
+        for (const Literal& t: softLiterals) {
+            if (softWeights.at(t) >= threshold) {
+                assumptions.push_back(t);
+            }
+        }
+        result = Result::Unknown;
+        core.clear();
+        search();
+        backtrack(0);
+        if (result == Result::Satisfiable) {
+            const std::uint64_t value = cost(model);
+            if (!hasModel || value < bestCost) {
+                bestCost = value;
+                best = model;
+                out << "o " << bestCost << std::endl;
+            }
+            hasModel = true;
+        } else if (result == Result::Unsatisfiable) {
+            if (!core.empty()) {
+                processCore(lowerBound);
+                out << "c lower bound " << lowerBound << std::endl;
+            }
+            if (core.empty()) {
+                // the hard clauses are unsatisfiable
+                optimum = Result::Unsatisfiable;
+                break;
+            }
+        } else {
+            break;
+        }
+    }
+    assumptions.clear();
+    result = optimum;
+    model = best;
+}
+
+// the core raises the lower bound by its lowest weight, which every
+// assumption in it loses; a sum in it may now have one more false input,
+// and a new sum bounds how many of the core are false beyond one
+template <class Config>
+void sat::Solver<Config>::processCore(std::uint64_t& lowerBound)
+{
+    std::uint64_t weight = std::numeric_limits<std::uint64_t>::max();
+    for (const Literal& t: core) {
+        weight = std::min(weight, softWeights.at(t));
+    }
+    lowerBound += weight;
+    std::vector<std::vector<Literal>> clauses;
+    auto assume = [&](const int totalizer, const int bound) {
+        const Literal t = totalizers[totalizer].output(bound).negate();
+        softLiterals.push_back(t);
+        softWeights[t] += weight;
+        sums[t] = {totalizer, bound};
+    };
+    std::vector<Literal> inputs;
+    for (const Literal& t: core) {
+        softWeights.at(t) -= weight;
+        inputs.push_back(t.negate());
+        auto sum = sums.find(t);
+        if (sum != sums.end()) {
+            const Sum next{sum->second.totalizer, sum->second.bound + 1};
+            Totalizer& totalizer = totalizers[next.totalizer];
+            if (next.bound < totalizer.numInputs()) {
+                totalizer.increase(next.bound + 1, [this]() { return newVariable(); }, clauses);
+                assume(next.totalizer, next.bound);
+            }
+        }
+    }
+    if (core.size() == 1) {
+        clauses.push_back(inputs);
+    } else {
+        totalizers.emplace_back(inputs);
+        totalizers.back().increase(2, [this]() { return newVariable(); }, clauses);
+        assume(totalizers.size() - 1, 1);
+    }
+    for (const std::vector<Literal>& clause: clauses) {
+        addClause(clause);
+    }
+    std::unordered_set<Literal> kept;
+    softLiterals.erase(std::remove_if(softLiterals.begin(), softLiterals.end(),
+                [&](const Literal& t) { return softWeights.at(t) == 0 || !kept.insert(t).second; }),
+            softLiterals.end());
+}
+
+namespace sat
+{
+    template void Solver<DefaultConfig<false, false>>::setSoftClauses(std::vector<SoftClause>&&);
+    template std::uint64_t Solver<DefaultConfig<false, false>>::cost(const std::vector<bool>&) const;
+    template void Solver<DefaultConfig<false, false>>::optimize();
+    template void Solver<DefaultConfig<false, false>>::processCore(std::uint64_t&);
+
+    template void Solver<DefaultConfig<false, true>>::setSoftClauses(std::vector<SoftClause>&&);
+    template std::uint64_t Solver<DefaultConfig<false, true>>::cost(const std::vector<bool>&) const;
+    template void Solver<DefaultConfig<false, true>>::optimize();
+    template void Solver<DefaultConfig<false, true>>::processCore(std::uint64_t&);
+
+    template void Solver<DefaultConfig<true, false>>::setSoftClauses(std::vector<SoftClause>&&);
+    template std::uint64_t Solver<DefaultConfig<true, false>>::cost(const std::vector<bool>&) const;
+    template void Solver<DefaultConfig<true, false>>::optimize();
+    template void Solver<DefaultConfig<true, false>>::processCore(std::uint64_t&);
+
+    template void Solver<DefaultConfig<true, true>>::setSoftClauses(std::vector<SoftClause>&&);
+    template std::uint64_t Solver<DefaultConfig<true, true>>::cost(const std::vector<bool>&) const;
+    template void Solver<DefaultConfig<true, true>>::optimize();
+    template void Solver<DefaultConfig<true, true>>::processCore(std::uint64_t&);
+}
@@ -0,0 +1,15 @@
+
+#include "memory.h"
+#include <fstream>
+#include <unistd.h>
+
+std::size_t sat::residentMemory()
+{
+    // second field of statm is the resident size in pages
+    std::ifstream statm("/proc/self/statm");
+    std::size_t size = 0, resident = 0;
+    if (!(statm >> size >> resident)) {
+        return 0;
+    }
+    return resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+}
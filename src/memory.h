@@ -0,0 +1,13 @@
+
+#ifndef SAT_MEMORY_H
+#define SAT_MEMORY_H
+
+#include <cstddef>
+
+namespace sat
+{
+    // resident set size of the process in bytes, 0 if it cannot be read
+    std::size_t residentMemory();
+}
+
+#endif // SAT_MEMORY_H
@@ -0,0 +1,91 @@
+
+#include "models.h"
+
+sat::ModelWriter::ModelWriter(std::ostream& out): out(out)
+{
+    buffer.reserve(BUFFER_SIZE);
+}
+
+sat::ModelWriter::~ModelWriter()
+{
+    flush();
+}
+
+void sat::ModelWriter::write(const std::vector<Literal>& cube, const int numFree)
+{
+    buffer += 'v';
+    for (const Literal& t: cube) {
+        writeLiteral(t);
+    }
+    buffer += " 0\n";
+    if (buffer.size() >= BUFFER_SIZE) {
+        flush();
+    }
+
+    // adds 2^numFree
+    cubes++;
+    std::size_t word = numFree / 32;
+    if (models.size() <= word) {
+        models.resize(word + 1, 0);
+    }
+    std::uint64_t carry = std::uint64_t(1) << (numFree % 32);
+    for (; carry > 0; word++) {
+        if (word == models.size()) {
+            models.push_back(0);
+        }
+        const std::uint64_t sum = models[word] + carry;
+        models[word] = static_cast<std::uint32_t>(sum);
+        carry = sum >> 32;
+    }
+}
+
+void sat::ModelWriter::flush()
+{
+    out.write(buffer.data(), buffer.size());
+    out.flush();
+    buffer.clear();
+}
+
+std::string sat::ModelWriter::count() const
+{
+    // repeated division by 10^9, from the most significant word
+    std::vector<std::uint32_t> n(models);
+    std::vector<std::uint32_t> groups;
+    while (!n.empty()) {
+        std::uint64_t remainder = 0;
+        for (std::size_t i = n.size(); i-- > 0;) {
+            const std::uint64_t value = (remainder << 32) | n[i];
+            n[i] = static_cast<std::uint32_t>(value / 1000000000);
+            remainder = value % 1000000000;
+        }
+        groups.push_back(static_cast<std::uint32_t>(remainder));
+        while (!n.empty() && n.back() == 0) {
+            n.pop_back();
+        }
+    }
+    if (groups.empty()) {
+        return "0";
+    }
+    std::string s = std::to_string(groups.back());
+    for (std::size_t i = groups.size() - 1; i-- > 0;) {
+        const std::string digits = std::to_string(groups[i]);
+        s += std::string(9 - digits.size(), '0') + digits;
+    }
+    return s;
+}
+
+void sat::ModelWriter::writeLiteral(const Literal& t)
+{
+    buffer += ' ';
+    if (!t.polarity()) {
+        buffer += '-';
+    }
+    char digits[12];
+    int n = 0;
+    for (int v = t.id(); v > 0; v /= 10) {
+        digits[n++] = static_cast<char>('0' + v % 10);
+    }
+    while (n > 0) {
+        buffer += digits[--n];
+    }
+}
@@ -0,0 +1,44 @@
+
+#ifndef SAT_MODELS_H
+#define SAT_MODELS_H
+
+#include "literal.h"
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace sat
+{
+    // streams enumerated models through a large buffer, one line
+    // "v 1 -3 0" per cube of models, the projected variables left out of
+    // a cube take either value; counts the models exactly
+    class ModelWriter
+    {
+    public:
+        explicit ModelWriter(std::ostream& out);
+        ~ModelWriter();
+        ModelWriter(const ModelWriter&) = delete;
+        ModelWriter& operator=(const ModelWriter&) = delete;
+
+        // a cube with numFree projected variables left out
+        void write(const std::vector<Literal>& cube, const int numFree);
+        void flush();
+        std::uint64_t numCubes() const { return cubes; }
+        // number of models, in decimal
+        std::string count() const;
+
+    private:
+        static const std::size_t BUFFER_SIZE = 1 << 16;
+
+        void writeLiteral(const Literal& t);
+
+        std::ostream& out;
+        std::string buffer;
+        std::uint64_t cubes = 0;
+        // binary digits of the model count, least significant first
+        std::vector<std::uint32_t> models;
+    };
+}
+
+#endif // SAT_MODELS_H
@@ -0,0 +1,50 @@
+
+#include "parallel.h"
+#include <algorithm>
+#include <exception>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+int sat::numThreads() noexcept
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+int sat::numParts(const std::size_t size, const std::size_t minSize) noexcept
+{
+    return static_cast<int>(std::max<std::size_t>(1,
+                std::min<std::size_t>(numThreads(), size / minSize)));
+}
+
+void sat::parallelFor(const int count, const std::function<void(int)>& body)
+{
+    std::vector<std::exception_ptr> errors(count);
+    auto run = [&](const int i) {
+        try {
+            body(i);
+        } catch (...) {
+            errors[i] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int i = 1; i < count; i++) {
+        try {
+            threads.emplace_back(run, i);
+        } catch (const std::system_error&) {
+            // out of threads, the part runs here then
+            run(i);
+        }
+    }
+    if (count > 0) {
+        run(0);
+    }
+    for (std::thread& thread: threads) {
+        thread.join();
+    }
+    for (const std::exception_ptr& error: errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
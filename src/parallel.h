@@ -0,0 +1,23 @@
+
+#ifndef SAT_PARALLEL_H
+#define SAT_PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+
+namespace sat
+{
+    // the hardware threads, at least 1
+    int numThreads() noexcept;
+
+    // the number of parts to split size items into, one per thread, each of
+    // at least minSize items, at least 1
+    int numParts(const std::size_t size, const std::size_t minSize) noexcept;
+
+    // runs body(0) to body(count - 1) on a thread each, the calling thread
+    // among them, and waits for all of them; the exception of the lowest
+    // part that threw is rethrown
+    void parallelFor(const int count, const std::function<void(int)>& body);
+}
+
+#endif // SAT_PARALLEL_H
@@ -1,30 +1,189 @@
 
 #include "parser.h"
 #include "literal.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
 #include <sstream>
+#include <stdexcept>
 #include <vector>
+#include <limits>
 #include <unordered_set>
 
-sat::Parser::Parser(std::string inputFile): fin(inputFile)
+namespace
+{
+    // the whole file, to be split into chunks
+    std::string readAll(std::ifstream& in)
+    {
+        std::string text;
+        in.seekg(0, std::ios::end);
+        const std::streamoff size = in.tellg();
+        in.seekg(0, std::ios::beg);
+        if (size > 0) {
+            text.resize(static_cast<std::size_t>(size));
+            in.read(&text[0], size);
+            text.resize(static_cast<std::size_t>(in.gcount()));
+        } else {
+            // not seekable
+            in.clear();
+            std::ostringstream out;
+            out << in.rdbuf();
+            text = out.str();
+        }
+        return text;
+    }
+
+    bool nextLine(const std::string& text, std::size_t& pos, std::string& line)
+    {
+        if (pos >= text.size()) {
+            return false;
+        }
+        std::size_t end = text.find('\n', pos);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        line.assign(text, pos, end - pos);
+        pos = end + 1;
+        return true;
+    }
+
+    bool isBlank(const char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    // clause lines, each read up to a 0 or anything but a number like the
+    // stream extraction of the other lines, and comments; tautologies are
+    // left out and duplicate literals dropped, with marks by variable
+    void parseChunk(const char* p, const char* end, const int numVars, sat::Formula& formula)
+    {
+        std::vector<signed char> marks(numVars + 1, 0);
+        std::vector<sat::Literal> literals;
+        while (p < end) {
+            const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+            if (eol == nullptr) {
+                eol = end;
+            }
+            const char c = *p;
+            if (p == eol || c == 'c') {
+                p = eol == end ? end : eol + 1;
+                continue;
+            } else if (c == 'p') {
+                throw std::invalid_argument("Invalid input file.");
+            } else if (c != '-' && (c <= '0' || c > '9')) {
+                throw std::invalid_argument("Invalid input file. Unrecognized format.");
+            }
+            literals.clear();
+            bool tautology = false;
+            while (p < eol) {
+                while (p < eol && isBlank(*p)) {
+                    p++;
+                }
+                const bool negative = p < eol && *p == '-';
+                if (p < eol && (*p == '-' || *p == '+')) {
+                    p++;
+                }
+                if (p == eol || *p < '0' || *p > '9') {
+                    break;
+                }
+                int var = 0;
+                while (p < eol && *p >= '0' && *p <= '9') {
+                    var = var * 10 + (*p++ - '0');
+                    if (var > numVars) {
+                        throw std::invalid_argument("Invalid input file, variable out of range.");
+                    }
+                }
+                if (var == 0) {
+                    break;
+                }
+                const signed char mark = negative ? -1 : 1;
+                if (marks[var] == 0) {
+                    marks[var] = mark;
+                    literals.push_back(sat::Literal(negative ? -var : var));
+                } else if (marks[var] != mark) {
+                    tautology = true;
+                }
+            }
+            for (const sat::Literal& t: literals) {
+                marks[t.id()] = 0;
+            }
+            if (!tautology && !literals.empty()) {
+                formula.addClause(sat::Clause(literals));
+            }
+            p = eol == end ? end : eol + 1;
+        }
+    }
+}
+
+sat::Parser::Parser(std::string inputFile): fin(inputFile, std::ios::binary)
 {
     if(!fin.good()) {
         throw std::invalid_argument("Cannot access file");
     }
 }
 
+std::vector<sat::Literal> sat::Parser::readLiterals(std::istream& in, bool& tautology)
+{
+    std::unordered_set<int> literalSet;
+    std::vector<Literal> literals;
+    tautology = false;
+    int var;
+    while (in >> var && var != 0) {
+        Literal t(var);
+        if (numVars > 0 && t.id() > numVars) {
+            throw std::invalid_argument("Invalid input file, variable out of range.");
+        }
+        if (literalSet.find(t.negate().index()) != literalSet.end()) {
+            tautology = true;
+        } else if (literalSet.find(t.index()) == literalSet.end()) {
+            literalSet.insert(t.index());
+            literals.push_back(t);
+            maxVar = std::max(maxVar, t.id());
+        }
+    }
+    return literals;
+}
+
+// split at line ends into a chunk per thread, each parsed into a formula
+// of its own; their clauses are then moved to formula in order
+void sat::Parser::parseClauses(const char* begin, const char* end, Formula& formula)
+{
+    const std::size_t size = end - begin;
+    const int parts = numParts(size, MIN_CHUNK_BYTES);
+    std::vector<const char*> bounds(1, begin);
+    for (int i = 1; i < parts; i++) {
+        const char* p = std::max(bounds.back(), begin + size / parts * i);
+        p = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        bounds.push_back(p == nullptr ? end : p + 1);
+    }
+    bounds.push_back(end);
+    std::vector<Formula> chunks;
+    chunks.reserve(parts);
+    for (int i = 0; i < parts; i++) {
+        chunks.emplace_back(numVars);
+    }
+    parallelFor(parts, [&](const int i) {
+        parseChunk(bounds[i], bounds[i + 1], numVars, chunks[i]);
+    });
+    for (Formula& chunk: chunks) {
+        formula.append(std::move(chunk));
+    }
+}
+
 sat::Formula sat::Parser::getFormula()
 {
     if (parsed) {
         throw std::logic_error("Solver already built.");
     }
 
+    const std::string text = readAll(fin);
+    std::size_t pos = 0;
     std::string line;
-    std::unordered_set<int> literalSet;
-    std::vector<Literal> literals;
     Formula formula(0);
 
     // parse lines
-    while (std::getline(fin, line)) {
+    while (nextLine(text, pos, line)) {
         if (line.empty()) {
             continue;
         }
@@ -33,40 +192,121 @@ sat::Formula sat::Parser::getFormula()
             // line is comment
             continue;
         } else if (c == 'p') {
-            if (numVars > 0) {
+            if (numVars > 0 || weighted) {
                 throw std::invalid_argument("Invalid input file.");
             }
             std::istringstream iss(line);
             std::string s, t;
             iss >> s >> t;
-            if (s != "p" || t != "cnf") {
+            if (s != "p" || (t != "cnf" && t != "wcnf")) {
                 throw std::invalid_argument("Invalid input file. Unrecognized format.");
             }
             iss >> numVars >> numClauses;
             if (numVars <= 0 || numClauses <= 0) {
                 throw std::invalid_argument("Invalid input file, bad number of variables or clauses.");
             }
+            weighted = t == "wcnf";
+            if (weighted && !(iss >> top)) {
+                // without top every clause is soft
+                top = std::numeric_limits<std::uint64_t>::max();
+            }
             formula = Formula(numVars);
+            if (!weighted) {
+                // only clauses and comments follow
+                parseClauses(text.data() + std::min(pos, text.size()), text.data() + text.size(),
+                        formula);
+                break;
+            }
+        } else if (c == 'h' && (numVars == 0 || weighted)) {
+            // hard clause of the format without a p line
+            weighted = true;
+            std::istringstream iss(line.substr(1));
+            bool tautology;
+            std::vector<Literal> literals = readLiterals(iss, tautology);
+            if (!tautology && !literals.empty()) {
+                clauses.push_back(Clause(literals));
+            }
         } else if (c == '-' || (c > '0' && c <= '9')) {
-            literalSet.clear();
-            literals.clear();
             std::istringstream iss(line);
-            int var;
-            while (iss >> var && var != 0) {
-                Literal t(var);
-                if (literalSet.find(t.id()) == literalSet.end()) {
-                    literalSet.insert(t.id());
-                    literals.push_back(t);
-                }
+            // clauses before any p line are weighted
+            weighted = weighted || numVars == 0;
+            std::uint64_t weight = top;
+            if (weighted && !(iss >> weight)) {
+                throw std::invalid_argument("Invalid input file, bad weight.");
             }
-            if (!literals.empty()) {
+            bool tautology;
+            std::vector<Literal> literals = readLiterals(iss, tautology);
+            if (tautology) {
+                continue;
+            } else if (weighted && (numVars == 0 || weight < top)) {
+                if (weight > 0) {
+                    softClauses.push_back({std::move(literals), weight});
+                }
+            } else if (literals.empty()) {
+                continue;
+            } else if (numVars > 0) {
                 formula.addClause(Clause(literals));
+            } else {
+                clauses.push_back(Clause(literals));
             }
         } else {
             throw std::invalid_argument("Invalid input file. Unrecognized format.");
         }
     } // end while
 
+    if (numVars == 0) {
+        if (maxVar == 0) {
+            throw std::invalid_argument("Invalid input file, no variables.");
+        }
+        formula = Formula(maxVar);
+        for (Clause& clause: clauses) {
+            formula.addClause(std::move(clause));
+        }
+        clauses.clear();
+    }
     parsed = true;
     return formula;
 }
+
+std::vector<sat::SoftClause> sat::Parser::getSoftClauses()
+{
+    if (!parsed) {
+        throw std::logic_error("Formula not parsed yet.");
+    }
+    return std::move(softClauses);
+}
+
+std::vector<sat::Literal> sat::readHint(const std::string& fileName)
+{
+    std::ifstream in(fileName);
+    if (!in) {
+        throw std::runtime_error("Cannot open hint file " + fileName);
+    }
+    std::vector<Literal> literals;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream iss(line);
+        std::string word;
+        if (!(iss >> word)) {
+            continue;
+        } else if (word != "v" && word[0] != '-' && !std::isdigit(static_cast<unsigned char>(word[0]))) {
+            // comments, and results like sat or s SATISFIABLE
+            continue;
+        } else if (word != "v") {
+            iss.clear();
+            iss.seekg(0);
+        }
+        long value;
+        while (iss >> value) {
+            if (value < -std::numeric_limits<int>::max() || value > std::numeric_limits<int>::max()) {
+                throw std::runtime_error("Invalid hint file, variable out of range");
+            } else if (value != 0) {
+                literals.push_back(Literal(static_cast<int>(value)));
+            }
+        }
+        if (!iss.eof()) {
+            throw std::runtime_error("Invalid hint file, bad literal");
+        }
+    }
+    return literals;
+}
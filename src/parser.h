@@ -7,6 +7,7 @@
 #include <iostream>
 #include <fstream>
 #include <memory>
+#include <cstdint>
 #include <vector>
 
 namespace sat
@@ -15,14 +16,35 @@ namespace sat
     {
     public:
         Parser(std::string inputFile);
+        // the hard clauses of a WCNF input
         Formula getFormula();
+        // WCNF, either with a p wcnf line, where clauses weighing top are
+        // hard, or with h marking hard clauses and no p line
+        bool isWeighted() const { return weighted; }
+        // after getFormula
+        std::vector<SoftClause> getSoftClauses();
 
     private:
+        // tautologies are flagged, duplicate literals dropped
+        std::vector<Literal> readLiterals(std::istream& in, bool& tautology);
+        void parseClauses(const char* begin, const char* end, Formula& formula);
+
+        // parsed by a thread each, with a p cnf line
+        static const std::size_t MIN_CHUNK_BYTES = 1 << 20;
+
         std::ifstream fin;
         bool parsed = false;
         int numVars = 0, numClauses = 0;
         std::vector<Clause> clauses;
+        bool weighted = false;
+        std::uint64_t top = 0;
+        std::vector<SoftClause> softClauses;
+        int maxVar = 0;
     };
+
+    // a partial or complete assignment, as literals in lines of the form
+    // "v 1 -2 0" or "1 -2 0" the solver prints; other lines are skipped
+    std::vector<Literal> readHint(const std::string& fileName); // can throw
 }
 
 #endif // SAT_PARSER_H
@@ -0,0 +1,234 @@
+
+#include "policy.h"
+#include <algorithm>
+#include <numeric>
+
+namespace
+{
+    // the i-th term, from 0, of the Luby sequence 1 1 2 1 1 2 4 ...
+    std::uint64_t luby(std::uint64_t i)
+    {
+        std::uint64_t size = 1;
+        int exponent = 0;
+        while (size < i + 1) {
+            exponent++;
+            size = 2 * size + 1;
+        }
+        while (size - 1 != i) {
+            size = (size - 1) >> 1;
+            exponent--;
+            i = i % size;
+        }
+        return std::uint64_t(1) << exponent;
+    }
+}
+
+void sat::VmtfDecision::addVariables(const int numVars)
+{
+    const int oldVars = static_cast<int>(links.size()) - 1;
+    links.resize(numVars + 1, Link{0, 0});
+    stamp.resize(numVars + 1, 0);
+    for (int v = numVars; v > oldVars; v--) {
+        enqueue(v);
+    }
+    searchVar = last;
+}
+
+void sat::VmtfDecision::bump(std::vector<int>& vars, const Assignment& assignment)
+{
+    // moved in the order they had, so earlier bumps keep their precedence
+    std::sort(vars.begin(), vars.end(), [&](int v1, int v2) { return stamp[v1] < stamp[v2]; });
+    for (int v: vars) {
+        if (v != last) {
+            dequeue(v);
+            enqueue(v);
+        }
+        if (!assignment.isAssigned(Literal(v))) {
+            searchVar = v;
+        }
+    }
+}
+
+void sat::VmtfDecision::dequeue(const int var) noexcept
+{
+    const Link link = links[var];
+    if (link.prev != 0) {
+        links[link.prev].next = link.next;
+    } else {
+        first = link.next;
+    }
+    if (link.next != 0) {
+        links[link.next].prev = link.prev;
+    } else {
+        last = link.prev;
+    }
+}
+
+void sat::VmtfDecision::enqueue(const int var) noexcept
+{
+    links[var] = {last, 0};
+    if (last != 0) {
+        links[last].next = var;
+    } else {
+        first = var;
+    }
+    last = var;
+    stamp[var] = ++counter;
+}
+
+void sat::VmtfDecision::reorder(const std::vector<int>& vars) noexcept
+{
+    for (int v: vars) {
+        dequeue(v);
+        enqueue(v);
+    }
+    searchVar = last;
+}
+
+void sat::ScoreDecision::addVariables(const int numVars)
+{
+    const int oldVars = static_cast<int>(score.size()) - 1;
+    score.resize(numVars + 1, 0.0);
+    position.resize(numVars + 1, -1);
+    for (int v = oldVars + 1; v <= numVars; v++) {
+        insert(v);
+    }
+}
+
+void sat::ScoreDecision::bump(const std::vector<int>& vars)
+{
+    for (int v: vars) {
+        score[v] += increment;
+        if (score[v] > RESCALE) {
+            for (double& s: score) {
+                s /= RESCALE;
+            }
+            increment /= RESCALE;
+        }
+        if (position[v] >= 0) {
+            siftUp(position[v]);
+        }
+    }
+}
+
+std::vector<double> sat::ScoreDecision::scores() const
+{
+    std::vector<double> relative(score.size());
+    for (std::size_t v = 1; v < score.size(); v++) {
+        relative[v] = score[v] / increment;
+    }
+    return relative;
+}
+
+void sat::ScoreDecision::setScores(const std::vector<double>& relative)
+{
+    increment = 1.0;
+    heap.clear();
+    for (std::size_t v = 1; v < score.size(); v++) {
+        score[v] = relative[v];
+        position[v] = -1;
+    }
+    for (int v = 1; v < static_cast<int>(score.size()); v++) {
+        insert(v);
+    }
+}
+
+sat::Literal sat::ScoreDecision::pick(const Assignment& assignment)
+{
+    // assigned variables are left in the heap until they come to the top
+    while (true) {
+        const int v = heap.front();
+        position[v] = -1;
+        heap.front() = heap.back();
+        heap.pop_back();
+        if (!heap.empty()) {
+            position[heap.front()] = 0;
+            siftDown(0);
+        }
+        if (!assignment.isAssigned(Literal(v))) {
+            return Literal(assignment.savedPhase(v) ? v : -v);
+        }
+    }
+}
+
+void sat::ScoreDecision::insert(const int var)
+{
+    position[var] = static_cast<int>(heap.size());
+    heap.push_back(var);
+    siftUp(position[var]);
+}
+
+void sat::ScoreDecision::siftUp(int i) noexcept
+{
+    const int var = heap[i];
+    while (i > 0) {
+        const int parent = (i - 1) / 2;
+        if (score[heap[parent]] >= score[var]) {
+            break;
+        }
+        heap[i] = heap[parent];
+        position[heap[i]] = i;
+        i = parent;
+    }
+    heap[i] = var;
+    position[var] = i;
+}
+
+void sat::ScoreDecision::siftDown(int i) noexcept
+{
+    const int var = heap[i];
+    const int size = static_cast<int>(heap.size());
+    while (2 * i + 1 < size) {
+        int child = 2 * i + 1;
+        if (child + 1 < size && score[heap[child + 1]] > score[heap[child]]) {
+            child++;
+        }
+        if (score[heap[child]] <= score[var]) {
+            break;
+        }
+        heap[i] = heap[child];
+        position[heap[i]] = i;
+        i = child;
+    }
+    heap[i] = var;
+    position[var] = i;
+}
+
+void sat::ModeSwitchingDecision::conflict(const std::uint64_t conflicts) noexcept
+{
+    if (isStable) {
+        stable.decay();
+    }
+    if (conflicts < nextSwitch) {
+        return;
+    }
+    // both modes get the same number of conflicts, doubled every round
+    isStable = !isStable;
+    switches++;
+    nextSwitch = conflicts + (MODE_INTERVAL << (switches / 2));
+    if (!isStable) {
+        focused.reset();
+    }
+}
+
+void sat::ModeSwitchingDecision::setActivities(const std::vector<double>& activities)
+{
+    stable.setScores(activities);
+    // the highest scores are decided first, ties by lowest number
+    std::vector<int> vars(activities.size() - 1);
+    std::iota(vars.begin(), vars.end(), 1);
+    std::stable_sort(vars.begin(), vars.end(), [&](int v1, int v2) {
+        return activities[v1] < activities[v2] || (activities[v1] == activities[v2] && v1 > v2);
+    });
+    focused.reorder(vars);
+}
+
+void sat::LubyRestarts::restarted(const std::uint64_t conflicts, const bool stable) noexcept
+{
+    wasStable = stable;
+    if (stable) {
+        next = conflicts + STABLE_UNIT * luby(stableCount++);
+    } else {
+        next = conflicts + FOCUSED_UNIT * luby(focusedCount++);
+    }
+}
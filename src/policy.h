@@ -0,0 +1,196 @@
+
+#ifndef SAT_POLICY_H
+#define SAT_POLICY_H
+
+#include "literal.h"
+#include "assignment.h"
+#include <cstdint>
+#include <vector>
+
+namespace sat
+{
+    // variable-move-to-front queue, focused mode: variables bumped by
+    // conflicts move to the end of a doubly linked list and get increasing
+    // timestamps; the search pointer caches a variable with every later one
+    // assigned, so bumping and picking are amortized constant time
+    class VmtfDecision
+    {
+    public:
+        // variables up to numVars join the queue, the lowest numbered last
+        void addVariables(const int numVars);
+        // vars analyzed in a conflict, bumped in their queue order
+        void bump(std::vector<int>& vars, const Assignment& assignment);
+        // before var is unassigned
+        void unassigned(const int var) noexcept
+        {
+            if (stamp[var] > stamp[searchVar]) {
+                searchVar = var;
+            }
+        }
+        // some variable must be unassigned
+        Literal pick(const Assignment& assignment) noexcept
+        {
+            while (assignment.isAssigned(Literal(searchVar))) {
+                searchVar = links[searchVar].prev;
+            }
+            return Literal(assignment.savedPhase(searchVar) ? searchVar : -searchVar);
+        }
+        // the search starts over from the last variable
+        void reset() noexcept { searchVar = last; }
+        // the queue is rebuilt with the variables in this order, last at the end
+        void reorder(const std::vector<int>& vars) noexcept;
+        std::size_t memoryUsage() const noexcept
+        {
+            return links.capacity() * sizeof(Link) + stamp.capacity() * sizeof(std::uint64_t);
+        }
+
+    private:
+        struct Link
+        {
+            int prev;
+            int next;
+        };
+
+        void dequeue(const int var) noexcept;
+        void enqueue(const int var) noexcept;
+
+        // indexed by variable, 0 ends the list
+        std::vector<Link> links = std::vector<Link>(1, Link{0, 0});
+        std::vector<std::uint64_t> stamp = std::vector<std::uint64_t>(1, 0);
+        int first = 0;
+        int last = 0;
+        int searchVar = 0;
+        std::uint64_t counter = 0;
+    };
+
+    // exponential variable state independent decaying sum, stable mode:
+    // bumping adds a growing increment to the score of a variable, and a
+    // binary heap holds every unassigned variable by score
+    class ScoreDecision
+    {
+    public:
+        void addVariables(const int numVars);
+        void bump(const std::vector<int>& vars);
+        // after every conflict
+        void decay() noexcept { increment /= DECAY; }
+        // scores relative to the current increment, indexed by variable
+        std::vector<double> scores() const;
+        // the heap is rebuilt with every variable
+        void setScores(const std::vector<double>& relative);
+        void unassigned(const int var)
+        {
+            if (position[var] < 0) {
+                insert(var);
+            }
+        }
+        // some variable must be unassigned
+        Literal pick(const Assignment& assignment);
+        std::size_t memoryUsage() const noexcept
+        {
+            return score.capacity() * sizeof(double)
+                + (heap.capacity() + position.capacity()) * sizeof(int);
+        }
+
+    private:
+        static constexpr double DECAY = 0.95;
+        static constexpr double RESCALE = 1e100;
+
+        void insert(const int var);
+        void siftUp(int i) noexcept;
+        void siftDown(int i) noexcept;
+
+        // indexed by variable
+        std::vector<double> score = std::vector<double>(1, 0.0);
+        // heap index of a variable, -1 if not in the heap
+        std::vector<int> position = std::vector<int>(1, -1);
+        std::vector<int> heap;
+        double increment = 1.0;
+    };
+
+    // alternates a focused mode, deciding by the VMTF queue, and a stable
+    // mode, deciding by scores, each mode lasting a geometrically growing
+    // number of conflicts; the queue and the heap both follow unassignments,
+    // conflicts only bump the variables of the current mode
+    class ModeSwitchingDecision
+    {
+    public:
+        void addVariables(const int numVars)
+        {
+            focused.addVariables(numVars);
+            stable.addVariables(numVars);
+        }
+        void bump(std::vector<int>& vars, const Assignment& assignment)
+        {
+            if (isStable) {
+                stable.bump(vars);
+            } else {
+                focused.bump(vars, assignment);
+            }
+        }
+        // after every conflict, with the conflicts so far
+        void conflict(const std::uint64_t conflicts) noexcept;
+        void unassigned(const int var)
+        {
+            focused.unassigned(var);
+            stable.unassigned(var);
+        }
+        Literal pick(const Assignment& assignment)
+        {
+            return isStable ? stable.pick(assignment) : focused.pick(assignment);
+        }
+        bool inStableMode() const noexcept { return isStable; }
+        // the scores, indexed by variable, also order the queue when set
+        std::vector<double> activities() const { return stable.scores(); }
+        void setActivities(const std::vector<double>& activities);
+        std::size_t memoryUsage() const noexcept
+        {
+            return focused.memoryUsage() + stable.memoryUsage();
+        }
+
+    private:
+        static const std::uint64_t MODE_INTERVAL = 1000;
+
+        VmtfDecision focused;
+        ScoreDecision stable;
+        bool isStable = false;
+        int switches = 0;
+        std::uint64_t nextSwitch = MODE_INTERVAL;
+    };
+
+    // Luby restarts, in units of few conflicts in focused mode and many in
+    // stable mode; a change of mode is due a restart
+    class LubyRestarts
+    {
+    public:
+        bool due(const std::uint64_t conflicts, const bool stable) const noexcept
+        {
+            return stable != wasStable || conflicts >= next;
+        }
+        void restarted(const std::uint64_t conflicts, const bool stable) noexcept;
+
+    private:
+        static const std::uint64_t FOCUSED_UNIT = 32;
+        static const std::uint64_t STABLE_UNIT = 512;
+
+        bool wasStable = false;
+        std::uint64_t next = FOCUSED_UNIT;
+        std::uint64_t focusedCount = 0;
+        std::uint64_t stableCount = 0;
+    };
+
+    // compile time configuration of the solver core; a feature turned off
+    // is compiled out of propagation and conflict analysis
+    template <class DecisionPolicy, class RestartPolicy, bool withProof, bool withStatistics>
+    struct Config
+    {
+        using Decision = DecisionPolicy;
+        using Restarts = RestartPolicy;
+        // DRAT proof logging
+        static const bool proof = withProof;
+        // counters of decisions, propagations and learned clauses; conflicts
+        // are always counted, they schedule restarts and reductions
+        static const bool statistics = withStatistics;
+    };
+}
+
+#endif // SAT_POLICY_H
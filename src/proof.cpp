@@ -0,0 +1,110 @@
+
+#include "proof.h"
+#include <stdexcept>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+sat::Proof::Proof(const std::string& outputFile, const bool binary):
+    binary(binary), buffer(BUFFER_SIZE)
+{
+    // O_TRUNC is ignored for pipes, so a checker can read on the fly
+    fd = ::open(outputFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::invalid_argument("Cannot open proof file");
+    }
+}
+
+sat::Proof::~Proof()
+{
+    try {
+        flush();
+    } catch (const std::runtime_error& e) {
+        // nothing sensible left to do with a broken proof
+    }
+    ::close(fd);
+}
+
+void sat::Proof::add(const Clause& clause)
+{
+    write(false, clause.begin(), clause.end());
+}
+
+void sat::Proof::add(const std::vector<Literal>& literals)
+{
+    write(false, literals.begin(), literals.end());
+}
+
+void sat::Proof::addEmpty()
+{
+    const std::vector<Literal> empty;
+    add(empty);
+}
+
+void sat::Proof::remove(const Clause& clause)
+{
+    write(true, clause.begin(), clause.end());
+}
+
+void sat::Proof::remove(const std::vector<Literal>& literals)
+{
+    write(true, literals.begin(), literals.end());
+}
+
+void sat::Proof::flush()
+{
+    writeBuffer();
+}
+
+void sat::Proof::writeLiteral(const Literal& t)
+{
+    if (binary) {
+        // variable length encoding of 2*var + sign, 7 bits at a time
+        unsigned int u = 2u * t.id() + (t.polarity() ? 0u : 1u);
+        while (u > 0x7f) {
+            put(static_cast<char>((u & 0x7f) | 0x80));
+            u >>= 7;
+        }
+        put(static_cast<char>(u));
+    } else {
+        if (!t.polarity()) {
+            put('-');
+        }
+        char digits[12];
+        int n = 0;
+        for (int v = t.id(); v > 0; v /= 10) {
+            digits[n++] = static_cast<char>('0' + v % 10);
+        }
+        while (n > 0) {
+            put(digits[--n]);
+        }
+        put(' ');
+    }
+}
+
+void sat::Proof::writeEnd()
+{
+    if (binary) {
+        put(0);
+    } else {
+        put('0');
+        put('\n');
+    }
+}
+
+void sat::Proof::writeBuffer()
+{
+    std::size_t written = 0;
+    while (written < pos) {
+        ssize_t n = ::write(fd, buffer.data() + written, pos - written);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            pos = 0;
+            throw std::runtime_error("Cannot write proof file");
+        }
+        written += n;
+    }
+    pos = 0;
+}
@@ -0,0 +1,71 @@
+
+#ifndef SAT_PROOF_H
+#define SAT_PROOF_H
+
+#include "literal.h"
+#include "clause.h"
+#include <string>
+#include <vector>
+
+namespace sat
+{
+    // writes a DRAT proof of unsatisfiability, in binary or text format,
+    // through a large output buffer; the output file can also be a pipe
+    class Proof
+    {
+    public:
+        Proof(const std::string& outputFile, const bool binary);
+        ~Proof();
+        Proof(const Proof&) = delete;
+        Proof& operator=(const Proof&) = delete;
+
+        void add(const Clause& clause);
+        void add(const std::vector<Literal>& literals);
+        void addEmpty();
+        void remove(const Clause& clause);
+        void remove(const std::vector<Literal>& literals);
+        void flush();
+
+    private:
+        static const std::size_t BUFFER_SIZE = 1 << 20;
+
+        template <class Iterator>
+        void write(const bool deletion, Iterator begin, Iterator end);
+        void writeLiteral(const Literal& t);
+        void writeEnd();
+        void put(const char c);
+        void writeBuffer();
+
+        int fd;
+        bool binary;
+        std::vector<char> buffer;
+        std::size_t pos = 0;
+    };
+
+    template <class Iterator>
+    void Proof::write(const bool deletion, Iterator begin, Iterator end)
+    {
+        if (deletion) {
+            put('d');
+            if (!binary) {
+                put(' ');
+            }
+        } else if (binary) {
+            put('a');
+        }
+        for (; begin != end; ++begin) {
+            writeLiteral(*begin);
+        }
+        writeEnd();
+    }
+
+    inline void Proof::put(const char c)
+    {
+        if (pos == buffer.size()) {
+            writeBuffer();
+        }
+        buffer[pos++] = c;
+    }
+}
+
+#endif // SAT_PROOF_H
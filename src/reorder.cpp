@@ -0,0 +1,97 @@
+
+#include "reorder.h"
+#include <algorithm>
+#include <numeric>
+
+std::vector<int> sat::renumberForLocality(Formula& formula)
+{
+    const int numVars = formula.numVariables();
+    const int numClauses = formula.numClauses();
+    // the clauses of each variable, as offsets into one array
+    std::vector<int> degree(numVars + 2, 0);
+    for (const Clause& clause: formula) {
+        for (const Literal& t: clause) {
+            degree[t.id()]++;
+        }
+    }
+    std::vector<int> start(numVars + 2, 0);
+    for (int v = 1; v <= numVars; v++) {
+        start[v + 1] = start[v] + degree[v];
+    }
+    std::vector<int> occurrences(start[numVars + 1]);
+    std::vector<int> filled(start.begin(), start.end() - 1);
+    std::vector<const Clause*> clauses;
+    clauses.reserve(numClauses);
+    for (const Clause& clause: formula) {
+        for (const Literal& t: clause) {
+            occurrences[filled[t.id()]++] = static_cast<int>(clauses.size());
+        }
+        clauses.push_back(&clause);
+    }
+
+    // components start from their variable of lowest degree
+    std::vector<int> byDegree(numVars);
+    std::iota(byDegree.begin(), byDegree.end(), 1);
+    std::stable_sort(byDegree.begin(), byDegree.end(),
+            [&](int v1, int v2) { return degree[v1] < degree[v2]; });
+    std::vector<int> order;
+    order.reserve(numVars);
+    std::vector<int> clauseOrder;
+    clauseOrder.reserve(numClauses);
+    std::vector<char> reached(numVars + 1, 0);
+    std::vector<char> laidOut(numClauses, 0);
+    std::vector<int> neighbors;
+    for (int first: byDegree) {
+        if (reached[first]) {
+            continue;
+        }
+        reached[first] = 1;
+        std::size_t head = order.size();
+        order.push_back(first);
+        while (head < order.size()) {
+            const int v = order[head++];
+            for (int i = start[v]; i < start[v + 1]; i++) {
+                const int c = occurrences[i];
+                if (laidOut[c]) {
+                    continue;
+                }
+                laidOut[c] = 1;
+                clauseOrder.push_back(c);
+                neighbors.clear();
+                for (const Literal& t: *clauses[c]) {
+                    if (!reached[t.id()]) {
+                        reached[t.id()] = 1;
+                        neighbors.push_back(t.id());
+                    }
+                }
+                std::sort(neighbors.begin(), neighbors.end(),
+                        [&](int v1, int v2) { return degree[v1] < degree[v2]; });
+                order.insert(order.end(), neighbors.begin(), neighbors.end());
+            }
+        }
+    }
+
+    // input variables first, each part in the order reached
+    const int numInputVars = formula.numInputVariables();
+    std::stable_partition(order.begin(), order.end(), [&](int v) { return v <= numInputVars; });
+    std::vector<int> original(numVars + 1, 0);
+    std::vector<int> renumbered(numVars + 1, 0);
+    for (int i = 0; i < numVars; i++) {
+        original[i + 1] = order[i];
+        renumbered[order[i]] = i + 1;
+    }
+    Formula result(numInputVars);
+    while (result.numVariables() < numVars) {
+        result.addVariable();
+    }
+    std::vector<Literal> literals;
+    for (int c: clauseOrder) {
+        literals.clear();
+        for (const Literal& t: *clauses[c]) {
+            literals.push_back(Literal(t.polarity() ? renumbered[t.id()] : -renumbered[t.id()]));
+        }
+        result.addClause(Clause(literals));
+    }
+    formula = std::move(result);
+    return original;
+}
@@ -0,0 +1,20 @@
+
+#ifndef SAT_REORDER_H
+#define SAT_REORDER_H
+
+#include "formula.h"
+#include <vector>
+
+namespace sat
+{
+    // renumbers the variables in Cuthill-McKee order of the graph of
+    // variables and clauses: breadth-first from a variable of lowest degree
+    // in each component, the variables of a clause by increasing degree;
+    // clauses are laid out in the order they are reached, so that those
+    // sharing variables are close in memory, and their variables close in
+    // the arrays indexed by variable; input variables keep numbers below
+    // fresh ones; returns the original number of each variable, 0 unused
+    std::vector<int> renumberForLocality(Formula& formula);
+}
+
+#endif // SAT_REORDER_H
@@ -0,0 +1,128 @@
+
+#include "solver.h"
+#include <stdexcept>
+
+template <class Config>
+void sat::Solver<Config>::setCheckpoint(const std::string& path)
+{
+    checkpointPath = path;
+    if (formulaHash == 0) {
+        formulaHash = formula.hash();
+    }
+}
+
+template <class Config>
+void sat::Solver<Config>::resume(const std::string& path)
+{
+    std::unique_ptr<Checkpoint> checkpoint = std::make_unique<Checkpoint>(readCheckpoint(path));
+    if (formulaHash == 0) {
+        formulaHash = formula.hash();
+    }
+    if (checkpoint->formulaHash != formulaHash) {
+        throw std::runtime_error("Checkpoint " + path + " is of another formula");
+    }
+    if (checkpoint->counters.size() != savedCounters().size()) {
+        throw std::runtime_error("Invalid checkpoint counters");
+    }
+    resumed = std::move(checkpoint);
+}
+
+// the statistics kept in a checkpoint, in their order there
+template <class Config>
+std::array<std::uint64_t*, 9> sat::Solver<Config>::savedCounters()
+{
+    return {&stats.conflicts, &stats.decisions, &stats.propagations, &stats.learnedClauses,
+        &stats.deletedClauses, &stats.reductions, &stats.restarts, &stats.rephases, &stats.flips};
+}
+
+template <class Config>
+void sat::Solver<Config>::saveCheckpoint()
+{
+    const int numVars = formula.numVariables();
+    Checkpoint checkpoint;
+    checkpoint.formulaHash = formulaHash;
+    checkpoint.numVars = numVars;
+    for (const std::uint64_t* counter: savedCounters()) {
+        checkpoint.counters.push_back(*counter);
+    }
+    const std::vector<Literal>& trail = assignment.trailLiterals();
+    checkpoint.units.assign(trail.begin(), trail.begin() + assignment.levelEnd(0));
+    checkpoint.phases.resize(numVars + 1);
+    for (int v = 1; v <= numVars; v++) {
+        const Literal t(v);
+        checkpoint.phases[v] = assignment.isAssigned(t) ? assignment.isTrue(t) : assignment.savedPhase(v);
+    }
+    checkpoint.activities = decision.activities();
+    int index = 0;
+    for (const Clause& clause: formula) {
+        if (index++ >= numOriginalClauses && addedClauses.find(&clause) == addedClauses.end()) {
+            checkpoint.learned.push_back({std::vector<Literal>(clause.begin(), clause.end()),
+                    clause.lbd()});
+        }
+    }
+    writeCheckpoint(checkpointPath, checkpoint);
+}
+
+// at level 0, before the search; the budgets count from the restored
+// counters on
+template <class Config>
+void sat::Solver<Config>::restore(const Checkpoint& checkpoint)
+{
+    // the same formula gets the same fresh variables
+    if (checkpoint.numVars != formula.numVariables()) {
+        throw std::runtime_error("Checkpoint is of another formula");
+    }
+    for (const Literal& t: checkpoint.units) {
+        if (assignment.isFalse(t)) {
+            setUnsatisfiable();
+            return;
+        } else if (!assignment.isAssigned(t)) {
+            assign(t, nullptr);
+        }
+    }
+    for (const Checkpoint::LearnedClause& learned: checkpoint.learned) {
+        Clause* clause = attachClause(learned.literals);
+        if (clause != nullptr) {
+            clause->setLbd(learned.lbd);
+        }
+        if (result != Result::Unknown) {
+            return;
+        }
+    }
+    for (int v = 1; v <= checkpoint.numVars; v++) {
+        assignment.setSavedPhase(v, checkpoint.phases[v]);
+    }
+    decision.setActivities(checkpoint.activities);
+    const std::array<std::uint64_t*, 9> counters = savedCounters();
+    for (std::size_t i = 0; i < counters.size(); i++) {
+        *counters[i] = checkpoint.counters[i];
+    }
+    budget.startAt(stats.conflicts, stats.propagations);
+}
+
+namespace sat
+{
+    template void Solver<DefaultConfig<false, false>>::setCheckpoint(const std::string&);
+    template void Solver<DefaultConfig<false, false>>::resume(const std::string&);
+    template std::array<std::uint64_t*, 9> Solver<DefaultConfig<false, false>>::savedCounters();
+    template void Solver<DefaultConfig<false, false>>::saveCheckpoint();
+    template void Solver<DefaultConfig<false, false>>::restore(const Checkpoint&);
+
+    template void Solver<DefaultConfig<false, true>>::setCheckpoint(const std::string&);
+    template void Solver<DefaultConfig<false, true>>::resume(const std::string&);
+    template std::array<std::uint64_t*, 9> Solver<DefaultConfig<false, true>>::savedCounters();
+    template void Solver<DefaultConfig<false, true>>::saveCheckpoint();
+    template void Solver<DefaultConfig<false, true>>::restore(const Checkpoint&);
+
+    template void Solver<DefaultConfig<true, false>>::setCheckpoint(const std::string&);
+    template void Solver<DefaultConfig<true, false>>::resume(const std::string&);
+    template std::array<std::uint64_t*, 9> Solver<DefaultConfig<true, false>>::savedCounters();
+    template void Solver<DefaultConfig<true, false>>::saveCheckpoint();
+    template void Solver<DefaultConfig<true, false>>::restore(const Checkpoint&);
+
+    template void Solver<DefaultConfig<true, true>>::setCheckpoint(const std::string&);
+    template void Solver<DefaultConfig<true, true>>::resume(const std::string&);
+    template std::array<std::uint64_t*, 9> Solver<DefaultConfig<true, true>>::savedCounters();
+    template void Solver<DefaultConfig<true, true>>::saveCheckpoint();
+    template void Solver<DefaultConfig<true, true>>::restore(const Checkpoint&);
+}
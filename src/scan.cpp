@@ -0,0 +1,92 @@
+
+#include "scan.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SAT_SCAN_X86 1
+#include <immintrin.h>
+#else
+#define SAT_SCAN_X86 0
+#endif
+
+static_assert(sizeof(sat::Literal) == sizeof(int),
+              "literals are gathered as 32 bit indices");
+
+std::size_t sat::scan::scalar(const Literal* lits, std::size_t begin,
+        std::size_t end, const signed char* values) noexcept
+{
+    std::size_t i = begin;
+    // unrolled, the four loads are independent
+    for (; i + 4 <= end; i += 4) {
+        const bool f0 = values[lits[i].index()] < 0;
+        const bool f1 = values[lits[i+1].index()] < 0;
+        const bool f2 = values[lits[i+2].index()] < 0;
+        const bool f3 = values[lits[i+3].index()] < 0;
+        if (!(f0 && f1 && f2 && f3)) {
+            return !f0 ? i : !f1 ? i+1 : !f2 ? i+2 : i+3;
+        }
+    }
+    for (; i < end; i++) {
+        if (values[lits[i].index()] >= 0) {
+            return i;
+        }
+    }
+    return end;
+}
+
+#if SAT_SCAN_X86
+
+__attribute__((target("avx2")))
+std::size_t sat::scan::avx2(const Literal* lits, std::size_t begin,
+        std::size_t end, const signed char* values) noexcept
+{
+    // each lane gathers 4 bytes at values + index, only the low byte is the
+    // value of the literal, the value array is padded for the 3 extra bytes
+    const __m256i lowByte = _mm256_set1_epi32(0xff);
+    const int* base = reinterpret_cast<const int*>(values);
+    std::size_t i = begin;
+    // two independent gathers per iteration, one branch for 16 literals
+    for (; i + 16 <= end; i += 16) {
+        const __m256i idx0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lits + i));
+        const __m256i idx1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lits + i + 8));
+        const __m256i v0 = _mm256_and_si256(_mm256_i32gather_epi32(base, idx0, 1), lowByte);
+        const __m256i v1 = _mm256_and_si256(_mm256_i32gather_epi32(base, idx1, 1), lowByte);
+        // false is -1, 0xff as the low byte
+        const unsigned f0 = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v0, lowByte)));
+        const unsigned f1 = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v1, lowByte)));
+        const unsigned mask = ~(f0 | (f1 << 8)) & 0xffffu;
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    for (; i + 8 <= end; i += 8) {
+        const __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lits + i));
+        const __m256i v = _mm256_and_si256(_mm256_i32gather_epi32(base, idx, 1), lowByte);
+        const unsigned mask = ~static_cast<unsigned>(
+                _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, lowByte)))) & 0xffu;
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return scalar(lits, i, end, values);
+}
+
+bool sat::scan::hasAvx2() noexcept
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+#else
+
+std::size_t sat::scan::avx2(const Literal* lits, std::size_t begin,
+        std::size_t end, const signed char* values) noexcept
+{
+    return scalar(lits, begin, end, values);
+}
+
+bool sat::scan::hasAvx2() noexcept
+{
+    return false;
+}
+
+#endif
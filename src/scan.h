@@ -0,0 +1,39 @@
+
+#ifndef SAT_SCAN_H
+#define SAT_SCAN_H
+
+#include "literal.h"
+#include <cstddef>
+
+namespace sat
+{
+    // kernels finding the first literal in lits[begin, end) that is not false
+    // under a dense value array indexed by Literal::index() (see Assignment);
+    // they return end if every literal is false
+    namespace scan
+    {
+        using Kernel = std::size_t (*)(const Literal* lits, std::size_t begin,
+                std::size_t end, const signed char* values);
+
+        std::size_t scalar(const Literal* lits, std::size_t begin,
+                std::size_t end, const signed char* values) noexcept;
+        // must only be called if hasAvx2()
+        std::size_t avx2(const Literal* lits, std::size_t begin,
+                std::size_t end, const signed char* values) noexcept;
+        bool hasAvx2() noexcept;
+
+        // the fastest kernel supported by the cpu, chosen at the first call,
+        // so that it may also be called while statics are initialized
+        inline std::size_t findNotFalse(const Literal* lits, std::size_t begin,
+                std::size_t end, const signed char* values) noexcept
+        {
+            static const Kernel kernel = hasAvx2() ? avx2 : scalar;
+            return kernel(lits, begin, end, values);
+        }
+
+        // shorter ranges are scanned inline by the caller
+        const std::size_t MIN_KERNEL_LENGTH = 16;
+    }
+}
+
+#endif // SAT_SCAN_H
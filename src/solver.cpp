@@ -1,180 +1,642 @@
 
 #include "solver.h"
-#include "timer.h"
+#include "budget.h"
 #include "debug.h"
+#include "memory.h"
+#include "xor.h"
+#include "bva.h"
+#include "parallel.h"
+#include "reorder.h"
+#include <array>
 #include <ostream>
-#include <map>
 #include <algorithm>
 #include <unordered_map>
 #include <iostream>
+#include <limits>
+#include <stdexcept>
 
 std::ostream& sat::operator<<(std::ostream& out, const sat::Result& v)
 {
-    static std::map<Result, std::string> str;
-    if (str.size() == 0) {
-        str[Result::Satisfiable] = "sat";
-        str[Result::Unsatisfiable] = "unsat";
-        str[Result::Unknown] = "unknown";
+    switch (v) {
+    case Result::Satisfiable:
+        return out << "sat";
+    case Result::Unsatisfiable:
+        return out << "unsat";
+    default:
+        return out << "unknown";
     }
-    return out << str.at(v);
 }
 
-void sat::Solver::printResult(const bool verbose)
+std::ostream& sat::operator<<(std::ostream& out, const sat::Statistics& s)
 {
-    std::ostream& out = std::cout;
+    return out << "Decisions: " << s.decisions
+               << ", conflicts: " << s.conflicts
+               << ", propagations: " << s.propagations
+               << ", learned clauses: " << s.learnedClauses
+               << ", deleted clauses: " << s.deletedClauses
+               << ", reductions: " << s.reductions
+               << ", restarts: " << s.restarts
+               << ", rephases: " << s.rephases
+               << ", flips: " << s.flips
+               << ", xors: " << s.xors
+               << ", cardinality constraints: " << s.cardinalities
+               << ", clauses replaced: " << s.replacedClauses
+               << ", variables added: " << s.addedVariables
+               << ", clauses reencoded: " << s.reencodedClauses;
+}
+
+template <class Config>
+void sat::Solver<Config>::printResult(const bool verbose)
+{
+    std::ostream& out = *output;
+    if (models) {
+        models->flush();
+    }
     out << result << std::endl;
+    if (models) {
+        out << "Models: " << models->count() << std::endl;
+    }
+    if (optimizing && !model.empty()) {
+        out << "Cost: " << bestCost << std::endl;
+    }
+    if (coreOut != nullptr && result == Result::Unsatisfiable) {
+        out << "Core: " << core.size() << " of " << inputClauses.size() << " clauses" << std::endl;
+    }
+    if (backboneOut != nullptr && result == Result::Satisfiable) {
+        out << "Backbone: " << backbone.size() << " of " << formula.numInputVariables()
+            << " variables";
+        if (uncheckedCandidates > 0) {
+            out << ", " << uncheckedCandidates << " candidates unchecked";
+        }
+        out << std::endl;
+    }
+    if (memoryOut) {
+        out << "Memory limit of " << memoryLimit / MEGABYTE << " MB reached, using "
+            << memoryUsage() / MEGABYTE << " MB" << std::endl;
+        out << stats << std::endl;
+    }
     if (!verbose) {
         return;
     }
     if (result == Result::Unknown) {
         out << "Current decisions: ";
         for (auto& t: assignment.decisions()) {
-            out << t << " ";
+            out << original(t) << " ";
         }
     } else if (result == Result::Unsatisfiable) {
-        out << "Last learned clause: " << lastLearnedClause;
-    } else {
-        std::vector<bool> values = assignment.values();
-        for (int i = 0; i < (int) values.size(); i++) {
-            out << (values.at(i) ? (i+1) : -(i+1)) << " ";
+        std::vector<Literal> literals;
+        for (const Literal& t: lastLearnedClause) {
+            literals.push_back(original(t));
+        }
+        out << "Last learned clause: " << Clause(literals);
+    } else if (!models) {
+        // fresh variables are not part of the model
+        for (int i = 0; i < formula.numInputVariables(); i++) {
+            out << (model.at(i) ? (i+1) : -(i+1)) << " ";
         }
         out << "0";
     }
     out << std::endl;
+    if (Config::statistics) {
+        out << stats << std::endl;
+    }
 }
 
-sat::Solver::Solver(Formula&& formula):
+// bound to a reference by the duration constructor
+template <class Config>
+const int sat::Solver<Config>::CHECKPOINT_SECONDS;
+
+// bound to a reference by std::min
+template <class Config>
+const std::uint64_t sat::Solver<Config>::BVA_STEPS;
+
+template <class Config>
+sat::Solver<Config>::Solver(Formula&& formula):
         formula(std::move(formula)),
+        numOriginalClauses(this->formula.numClauses()),
         assignment(this->formula.numVariables()),
+        reasons(this->formula.numVariables() + 1, Reason{nullptr, -1}),
         comparator(assignment),
         confLitCurrLvl(comparator),
         confLitLowerLvl(comparator)
-{}
+{
+    decision.addVariables(this->formula.numVariables());
+}
+
+template <class Config>
+void sat::Solver<Config>::solve(const int timeLimitSeconds, const bool verbose)
+{
+    run(timeLimitSeconds, &std::cout);
+    printResult(verbose);
+}
+
+template <class Config>
+void sat::Solver<Config>::run(const int timeLimitSeconds, std::ostream* output)
+{
+    this->output = output;
+    Watchdog watchdog(budget, std::chrono::seconds(timeLimitSeconds));
+    if (memoryLimit > 0) {
+        const std::size_t resident = residentMemory();
+        const std::size_t accounted = memoryUsage();
+        memoryBaseline = resident > accounted ? resident - accounted : 0;
+    }
+    if (reordering) {
+        renumber();
+    }
+    solveFormula();
+    if (!originalVariables.empty() && !model.empty()) {
+        // fresh variables of the solve keep their numbers
+        std::vector<bool> values(model);
+        for (std::size_t v = 1; v < originalVariables.size(); v++) {
+            values[originalVariables[v] - 1] = model[v - 1];
+        }
+        model = std::move(values);
+    }
+}
 
-void sat::Solver::solve(const int timeLimitSeconds, const bool verbose)
+template <class Config>
+void sat::Solver<Config>::solveFormula()
 {
-    Timer timer(timeLimitSeconds);
-    timer.start();
-    pureLiteralElimination();
-    processSingleLiteralClauses();
+    if (!hint.empty()) {
+        seedHint();
+    }
+    if (localSearchOnly) {
+        solveLocally();
+        return;
+    }
+    // only a model of the formula as given is a result
+    if (!hint.empty() && !models && !optimizing && coreOut == nullptr && backboneOut == nullptr) {
+        repairHint();
+        if (result != Result::Unknown) {
+            return;
+        }
+    }
+    if (coreOut != nullptr) {
+        // selectors would be taken for pure literals, and would keep clauses
+        // from being replaced by cardinality constraints or reencoded
+        addSelectors();
+    } else if (!models) {
+        // both lose models, and the clauses are needed to shrink cubes;
+        // variables only in soft clauses would be taken for pure ones, and
+        // fixing pure literals changes the backbone
+        if (!optimizing && backboneOut == nullptr) {
+            pureLiteralElimination();
+        }
+        propagateUnits();
+        if (!hasConflict) {
+            initCardinality();
+            reencode();
+        }
+    }
+    if (!hasConflict) {
+        processSingleLiteralClauses();
+    }
+    // a time limit reached while preprocessing skips the passes left
     if (hasConflict) {
-        result = Result::Unsatisfiable;
+        setUnsatisfiable();
+    } else if (!stopped()) {
+        initXors();
+    }
+    if (resumed && result == Result::Unknown) {
+        restore(*resumed);
+        resumed.reset();
     }
-    timer.stop();
-    while (!canceled && result == Result::Unknown
-                && (timeLimitSeconds <= 0 || !timer.timeout())) {
-        timer.start();
+    if (!hint.empty() && result == Result::Unknown) {
+        tryHint();
+    }
+    if (result == Result::Unknown && !stopped()) {
+        rephase();
+    }
+    nextCheckpoint = std::chrono::steady_clock::now() + std::chrono::seconds(CHECKPOINT_SECONDS);
+    if (optimizing && result == Result::Unknown) {
+        optimize();
+    } else if (coreOut != nullptr && result == Result::Unknown) {
+        findCore();
+    } else if (backboneOut != nullptr && result != Result::Unsatisfiable) {
+        findBackbone();
+    } else {
+        search();
+    }
+    if (!checkpointPath.empty() && result == Result::Unknown) {
+        saveCheckpoint();
+    }
+}
+
+// CDCL until there is a result, or a limit is reached
+template <class Config>
+void sat::Solver<Config>::search()
+{
+    while (result == Result::Unknown && !stopped()) {
         unitPropagation();
         if (hasConflict) {
+            stats.conflicts++;
+            poll();
             if (assignment.currentLevel() > 0) {
-                int backtrackLevel = analyzeConflict();
-                backtrack(backtrackLevel);
+                analyzeConflict();
+                if (memoryLimit > 0) {
+                    checkMemory();
+                }
             } else {
-                result = Result::Unsatisfiable;
+                setUnsatisfiable();
             }
         } else {
-            if (assignment.allAssigned()) {
-                result = Result::Satisfiable;
+            if (assignment.allAssigned()
+                    && assignment.currentLevel() >= static_cast<int>(assumptions.size())) {
+                if (models) {
+                    blockModel();
+                } else {
+                    setSatisfiable(assignment.values());
+                }
             } else {
-                makeDecision();
+                if (stats.conflicts >= nextRephase) {
+                    rephase();
+                } else if (restarts.due(stats.conflicts, decision.inStableMode())) {
+                    restart();
+                }
+                if (result == Result::Unknown) {
+                    makeDecision();
+                }
             }
         }
-        timer.stop();
     }
-    printResult(verbose);
 }
 
-void sat::Solver::cancel()
+// at a limit, or stopped by cancel, the watchdog or the termination
+// callback; the callback is also polled here, every so many checks, for
+// searches long without conflicts and for checks of cores and backbones
+template <class Config>
+bool sat::Solver<Config>::stopped()
 {
-    canceled = true;
+    if (terminate && ++terminationChecks % TERMINATION_INTERVAL == 0 && terminate()) {
+        budget.stop();
+    }
+    return memoryOut || budget.exhausted(stats.conflicts, stats.propagations);
 }
 
-// eliminates literals that never appeared or only appeared in one polarity
-void sat::Solver::pureLiteralElimination()
+// for the passes before the search, which poll seldom, the termination
+// callback is asked on every poll
+template <class Config>
+bool sat::Solver<Config>::pollStopped()
 {
-    std::unordered_map<int, signed char> literals;
-    for (auto& clause: formula) {
-        for (const Literal& t: clause) {
-            signed char p = t.polarity() ? 1 : -1;
-            if (literals.find(t.id()) != literals.end()) {
-                if (literals.at(t.id()) != p) {
-                    literals[t.id()] = 0;
-                }
-            } else {
-                literals[t.id()] = p;
+    if (terminate && terminate()) {
+        budget.stop();
+    }
+    return stopped();
+}
+
+template <class Config>
+void sat::Solver<Config>::setReordering(const bool enabled)
+{
+    reordering = enabled;
+}
+
+// hinted literals are renumbered along
+template <class Config>
+void sat::Solver<Config>::renumber()
+{
+    originalVariables = renumberForLocality(formula);
+    std::vector<int> renumbered(originalVariables.size(), 0);
+    for (std::size_t v = 1; v < originalVariables.size(); v++) {
+        renumbered[originalVariables[v]] = static_cast<int>(v);
+    }
+    for (Literal& t: hint) {
+        t = Literal(t.polarity() ? renumbered[t.id()] : -renumbered[t.id()]);
+    }
+}
+
+template <class Config>
+sat::Literal sat::Solver<Config>::original(const Literal& t) const
+{
+    if (t.id() >= static_cast<int>(originalVariables.size())) {
+        return t;
+    }
+    const int v = originalVariables[t.id()];
+    return Literal(t.polarity() ? v : -v);
+}
+
+template <class Config>
+void sat::Solver<Config>::setConflictLimit(const std::uint64_t conflicts)
+{
+    budget.setConflicts(conflicts);
+}
+
+template <class Config>
+void sat::Solver<Config>::setPropagationLimit(const std::uint64_t propagations)
+{
+    if (!Config::statistics) {
+        throw std::logic_error("Solver built without counting propagations");
+    }
+    budget.setPropagations(propagations);
+}
+
+template <class Config>
+void sat::Solver<Config>::setProof(Proof* proof)
+{
+    if (!Config::proof && proof != nullptr) {
+        throw std::logic_error("Solver built without proof logging");
+    }
+    this->proof = proof;
+}
+
+template <class Config>
+void sat::Solver<Config>::setMemoryLimit(const std::size_t megabytes)
+{
+    memoryLimit = megabytes * MEGABYTE;
+}
+
+template <class Config>
+void sat::Solver<Config>::setLocalSearchOnly(const bool enabled)
+{
+    localSearchOnly = enabled;
+}
+
+template <class Config>
+void sat::Solver<Config>::setSatisfiable(const std::vector<bool>& values)
+{
+    result = Result::Satisfiable;
+    model = values;
+}
+
+template <class Config>
+void sat::Solver<Config>::setUnsatisfiable()
+{
+    if (models && models->numCubes() > 0) {
+        // every model is enumerated
+        result = Result::Satisfiable;
+        return;
+    }
+    result = Result::Unsatisfiable;
+    if (Config::proof && proof != nullptr) {
+        proof->addEmpty();
+        proof->flush();
+    }
+}
+
+// eliminates literals that never appeared or only appeared in one polarity;
+// the polarities are collected for parts of the clauses in parallel, then
+// merged for parts of the variables
+template <class Config>
+void sat::Solver<Config>::pureLiteralElimination()
+{
+    const int numVars = formula.numVariables();
+    const int numClauses = formula.numClauses();
+    const int parts = numParts(numClauses, MIN_PART_CLAUSES);
+    // 1 for positive occurrences, 2 for negative ones, both 3
+    std::vector<std::vector<unsigned char>> polarities(parts);
+    parallelFor(parts, [&](const int i) {
+        std::vector<unsigned char>& seen = polarities[i];
+        seen.assign(numVars + 1, 0);
+        for (int c = partBegin(numClauses, parts, i); c < partBegin(numClauses, parts, i + 1); c++) {
+            for (const Literal& t: formula.clause(c)) {
+                seen[t.id()] |= t.polarity() ? 1 : 2;
             }
         }
-    }
+    });
+    std::vector<unsigned char>& seen = polarities[0];
+    parallelFor(parts, [&](const int i) {
+        for (int v = partBegin(numVars + 1, parts, i); v < partBegin(numVars + 1, parts, i + 1); v++) {
+            for (int j = 1; j < parts; j++) {
+                seen[v] |= polarities[j][v];
+            }
+        }
+    });
 
-    for (int v = 1; v <= formula.numVariables(); v++) {
-        if (literals.find(v) == literals.end()) {
+    for (int v = 1; v <= numVars; v++) {
+        if (seen[v] == 0) {
             // never appeared in any clause, value doesn't matter
-            assignment.assign(Literal(v));
-        } else {
-            if (literals.at(v) != 0) {
-                // pure literal, only one polarity
-                assignment.assign(Literal(v * (literals.at(v) > 0 ? 1 : -1)));
-            }
+            assignment.set(Literal(v));
+        } else if (seen[v] != 3) {
+            // pure literal, only one polarity
+            assignment.set(Literal(seen[v] == 1 ? v : -v));
         }
     }
 }
 
-void sat::Solver::processSingleLiteralClauses()
+// the units of the input are propagated over occurrence lists before any
+// clause is watched, so that cardinality detection and reencoding see the
+// formula without the clauses satisfied at level 0 and without the false
+// literals; clauses are shortened as processSingleLiteralClauses does
+template <class Config>
+void sat::Solver<Config>::propagateUnits()
 {
+    const int numClauses = formula.numClauses();
+    std::vector<Literal> units;
+    for (int c = 0; c < numClauses; c++) {
+        const Clause& clause = formula.clause(c);
+        if (clause.size() == 1) {
+            const Literal& t = *clause.begin();
+            if (assignment.isFalse(t)) {
+                markConflict(clause);
+                return;
+            } else if (!assignment.isAssigned(t)) {
+                assign(t, nullptr);
+                units.push_back(t);
+            }
+        }
+    }
+    if (units.empty()) {
+        return;
+    }
+    std::vector<std::vector<int>> occurrences(2 * (formula.numVariables() + 1));
+    for (int c = 0; c < numClauses; c++) {
+        for (const Literal& t: formula.clause(c)) {
+            occurrences[t.index()].push_back(c);
+        }
+    }
+    for (std::size_t i = 0; i < units.size(); i++) {
+        for (int c: occurrences[units[i].negate().index()]) {
+            const Clause& clause = formula.clause(c);
+            const Literal* unassigned = nullptr;
+            int numUnassigned = 0;
+            bool isTrue = false;
+            for (const Literal& t: clause) {
+                if (assignment.isTrue(t)) {
+                    isTrue = true;
+                    break;
+                } else if (!assignment.isAssigned(t)) {
+                    unassigned = &t;
+                    numUnassigned++;
+                }
+            }
+            if (isTrue || numUnassigned > 1) {
+                continue;
+            }
+            if (numUnassigned == 0) {
+                markConflict(clause);
+                return;
+            }
+            assign(*unassigned, nullptr);
+            units.push_back(*unassigned);
+        }
+    }
+    DBGPRINT("propagated " << units.size() << " units of the input");
+
+    // satisfied clauses are left out without a proof step, the units stay
     std::vector<Literal> literals;
-    for (Clause& clause: formula) {
+    for (int c = 0; c < numClauses; c++) {
+        Clause& clause = formula.clause(c);
         literals.clear();
-        bool isAlreadyTrue = false;
+        bool isTrue = false;
         for (const Literal& t: clause) {
             if (assignment.isTrue(t)) {
-                isAlreadyTrue = true;
+                isTrue = true;
                 break;
-            } else if (!assignment.isAssigned(t)){
+            } else if (!assignment.isAssigned(t)) {
                 literals.push_back(t);
             }
         }
-        if (isAlreadyTrue) {
-            // clause is already true
-            continue;
+        if (!isTrue && literals.size() != clause.size()) {
+            if (Config::proof && proof != nullptr) {
+                proof->add(literals);
+                proof->remove(clause);
+            }
+            clause = Clause(literals);
         }
-        if (literals.empty()) {
-            // all literals are false
-            markConflict(clause);
-            break;
+    }
+    numOriginalClauses -= formula.removeClauses(0, [&](const Clause& clause) {
+        return std::any_of(clause.begin(), clause.end(),
+                [&](const Literal& t) { return assignment.isTrue(t); });
+    });
+    // local search only sees the clauses, which keep the level 0 literals
+    // as units in place of those satisfied by them
+    for (const Literal& t: assignment.trailLiterals()) {
+        literals.assign(1, t);
+        formula.addClause(Clause(literals));
+        numOriginalClauses++;
+    }
+}
+
+// the clauses are classified against the assignment in parallel, for parts
+// of them: true ones are left out, false literals are removed from the
+// others, and units collected; in order, the shorter clauses then replace
+// the others and units are assigned, while the watches go to lists for
+// parts of the literals, which are filled in parallel; a clause containing
+// a unit assigned here is watched, and propagation catches up on it
+template <class Config>
+void sat::Solver<Config>::processSingleLiteralClauses()
+{
+    struct Part
+    {
+        std::vector<std::pair<Clause*, std::vector<Literal>>> shortened;
+        std::vector<Clause*> units;
+        Clause* conflict = nullptr;
+        // by part of the literals, their indices and clauses
+        std::vector<std::vector<std::pair<int, Clause*>>> watches;
+    };
+    const int numClauses = formula.numClauses();
+    const int numLiterals = 2 * (formula.numVariables() + 1);
+    const int parts = numParts(numClauses, MIN_PART_CLAUSES);
+    auto literalPart = [&](const Literal& t) {
+        return static_cast<int>(static_cast<std::int64_t>(t.index()) * parts / numLiterals);
+    };
+    std::vector<Part> results(parts);
+    parallelFor(parts, [&](const int i) {
+        Part& part = results[i];
+        part.watches.resize(parts);
+        std::vector<Literal> literals;
+        for (int c = partBegin(numClauses, parts, i); c < partBegin(numClauses, parts, i + 1); c++) {
+            Clause& clause = formula.clause(c);
+            literals.clear();
+            bool isAlreadyTrue = false;
+            for (const Literal& t: clause) {
+                if (assignment.isTrue(t)) {
+                    isAlreadyTrue = true;
+                    break;
+                } else if (!assignment.isAssigned(t)) {
+                    literals.push_back(t);
+                }
+            }
+            if (isAlreadyTrue) {
+                continue;
+            }
+            if (literals.empty()) {
+                // all literals are false
+                part.conflict = &clause;
+                break;
+            }
+            if (literals.size() == 1) {
+                part.units.push_back(&clause);
+            } else {
+                part.watches[literalPart(literals[0])].push_back({literals[0].index(), &clause});
+                part.watches[literalPart(literals[1])].push_back({literals[1].index(), &clause});
+            }
+            if (literals.size() != clause.size()) {
+                part.shortened.push_back({&clause, literals});
+            }
         }
-        if (literals.size() != clause.size()) {
-            clause = Clause(literals);
+    });
+
+    for (Part& part: results) {
+        for (auto& shortened: part.shortened) {
+            // false literals are removed, the shorter clause replaces it
+            if (Config::proof && proof != nullptr) {
+                proof->add(shortened.second);
+                proof->remove(*shortened.first);
+            }
+            *shortened.first = Clause(shortened.second);
         }
-        if (clause.size() == 1) {
+        for (Clause* clause: part.units) {
             // single literal clause, literal has to be true
-            assertLiteral(*clause.begin());
-            if (hasConflict) {
-                break;
+            const Literal& t = *clause->begin();
+            if (assignment.isFalse(t)) {
+                markConflict(*clause);
+                return;
+            } else if (!assignment.isAssigned(t)) {
+                assign(t, nullptr);
             }
+        }
+        if (part.conflict != nullptr) {
+            markConflict(*part.conflict);
+            return;
+        }
+    }
+
+    std::vector<ClauseList> lists(numLiterals);
+    parallelFor(parts, [&](const int j) {
+        for (const Part& part: results) {
+            for (const std::pair<int, Clause*>& watch: part.watches[j]) {
+                lists[watch.first].push_back(*watch.second);
+            }
+        }
+    });
+    for (int x = 0; x < numLiterals; x++) {
+        if (lists[x].empty()) {
+            continue;
+        }
+        watchEntries += lists[x].size();
+        const Literal t = Literal::fromIndex(x);
+        auto it = watchList.find(t);
+        if (it == watchList.end()) {
+            watchList.emplace(t, std::move(lists[x]));
         } else {
-            // has 2 or more unassigned literals
-            addToWatchList(clause.w1(), clause);
-            addToWatchList(clause.w2(), clause);
+            it->second.insert(it->second.end(), lists[x].begin(), lists[x].end());
         }
     }
 }
 
-void sat::Solver::addToWatchList(const Literal& t, Clause& clause)
+template <class Config>
+void sat::Solver<Config>::addToWatchList(const Literal& t, Clause& clause)
 {
     if (watchList.find(t) == watchList.end()) {
         watchList.insert({t, ClauseList()});
     }
     watchList.at(t).push_back(clause);
+    watchEntries++;
 }
 
-void sat::Solver::assertLiteral(const Literal& t)
+// t is assigned at once, and propagated when the trail reaches it
+template <class Config>
+void sat::Solver<Config>::assign(const Literal& t, const Clause* reason)
 {
-    DBGPRINT("asserting " << t);
-    assignment.assign(t);
-    updateWatches(t.negate());
+    if (Config::statistics) {
+        stats.propagations++;
+    }
+    assignment.set(t);
+    reasons[t.id()] = {reason, -1};
 }
 
-void sat::Solver::updateWatches(const Literal& t)
+template <class Config>
+void sat::Solver<Config>::updateWatches(const Literal& t)
 {
     if (watchList.find(t) != watchList.end()) {
         ClauseList& watchedClauses = watchList.at(t);
@@ -197,34 +659,33 @@ void sat::Solver::updateWatches(const Literal& t)
                 newWatchedClauses.push_back(clause);
             } else {
                 if (!assignment.isAssigned(clause.w1())) {
-                    Literal p = clause.w1();
-                    propagationQueue.push_back(p);
-                    DBGPRINT("reason for propagating " << p << ": " << clause);
-                    // the literal might not get propagated, but it's ok
-                    // in such case we'll never to get to analyze it, so it
-                    // doesn't matter if there's an abandoned reason for it
-                    setReason(p, clause);
+                    DBGPRINT("reason for propagating " << clause.w1() << ": " << clause);
+                    assign(clause.w1(), &clause);
                 }
                 newWatchedClauses.push_back(clause);
             }
         }
+        watchEntries -= watchedClauses.size() - newWatchedClauses.size();
         watchList[t] = newWatchedClauses;
     }
 }
 
-void sat::Solver::markConflict(const sat::Clause& clause)
+template <class Config>
+void sat::Solver<Config>::markConflict(const sat::Clause& clause)
 {
     hasConflict = true;
     conflictClause = &clause;
 }
 
-void sat::Solver::clearConflict()
+template <class Config>
+void sat::Solver<Config>::clearConflict()
 {
     hasConflict = false;
     conflictClause = nullptr;
 }
 
-void sat::Solver::addLiterals(const sat::Clause& clause)
+template <class Config>
+void sat::Solver<Config>::addLiterals(const sat::Clause& clause)
 {
     DBGPRINT("adding literals from " << clause);
     for (const Literal& t: clause) {
@@ -232,26 +693,19 @@ void sat::Solver::addLiterals(const sat::Clause& clause)
             && conflictLiterals.find(t.id()) == conflictLiterals.end()) {
             // only process t once
             conflictLiterals.insert(t.id());
-            if (assignment.level(t) == assignment.currentLevel()) {
+            if (assignment.levelOf(t) == assignment.currentLevel()) {
                 confLitCurrLvl.insert(t);
-            } else if (assignment.level(t) > 0) {
+                analyzedVariables.push_back(t.id());
+            } else if (assignment.levelOf(t) > 0) {
                 confLitLowerLvl.insert(t);
+                analyzedVariables.push_back(t.id());
             }
         }
     }
 }
 
-void sat::Solver::setReason(const sat::Literal& t, const sat::Clause& clause)
-{
-    // stores const reference to clause as the reason
-    auto pair = upReasons.insert({t, clause});
-    if (!pair.second) {
-        // update the value reference
-        pair.first->second = clause;
-    }
-}
-
-int sat::Solver::analyzeConflict()
+template <class Config>
+void sat::Solver<Config>::analyzeConflict()
 {
     DBGPRINT("current level " << assignment.currentLevel());
     DBGPRINT("conflict clause " << *conflictClause);
@@ -267,86 +721,552 @@ int sat::Solver::analyzeConflict()
         // opposite polarity was decided or propagated
         Literal tn = t.negate();
         DBGPRINT("analyzing assigned literal: " << tn);
-        if (upReasons.find(tn) == upReasons.end()) {
+        const Reason& reason = reasons[tn.id()];
+        if (reason.clause != nullptr) {
+            addLiterals(*reason.clause);
+        } else if (reason.constraint >= 0) {
+            std::vector<Literal> explanation;
+            cardinality->explain(tn, reason.constraint, explanation);
+            addLiterals(Clause(explanation));
+        } else {
             // if there is no reason, it means the literal is either
             // a decision or
             // a singal literal clause learned from an earlier backtrack
             continue;
         }
-        const Clause& clause = upReasons.at(tn);
-        addLiterals(clause);
         confLitCurrLvl.erase(t);
         DBGPRINTC("conflicts current level: ", confLitCurrLvl);
         DBGPRINTC("conflicts lower level: ", confLitLowerLvl);
     }
     std::vector<Literal> literals(confLitLowerLvl.begin(), confLitLowerLvl.end());
+    // in trail order, so the levels do not decrease
+    std::uint32_t lbd = 1;
+    int lastLevel = -1;
+    for (const Literal& t: literals) {
+        if (assignment.levelOf(t) != lastLevel) {
+            lastLevel = assignment.levelOf(t);
+            lbd++;
+        }
+    }
     // every conflict literals at lower level are false, so this one has to
     // be true to make the conflict/learned clause true; it effectively
     // becomes a unit clause
     // current assignment is false: -lastLiteral
     Literal lastLiteral = *confLitCurrLvl.begin();
     literals.push_back(lastLiteral);
+    if (sharing && literals.size() <= MAX_SHARED_SIZE && sharedClauses.size() < MAX_SHARED_CLAUSES
+            && std::all_of(literals.begin(), literals.end(), [&](const Literal& t) {
+                return t.id() <= formula.numInputVariables(); })) {
+        sharedClauses.push_back(literals);
+    }
+    if (Config::proof && proof != nullptr) {
+        proof->add(literals);
+    }
     // if clause will have more than 1 literal
+    const Clause* reason = nullptr;
     if (literals.size() > 1) {
         // w1 will be last assigned literal, and w2 will be the second last
         std::reverse(literals.begin(), literals.end());
         // add to formula
         Clause& learnedClause = formula.addClause(Clause(literals));
         DBGPRINT("learned clause " << learnedClause);
-        setReason(lastLiteral, learnedClause);
+        learnedClause.setLbd(lbd);
+        reason = &learnedClause;
         addToWatchList(learnedClause.w1(), learnedClause);
         addToWatchList(learnedClause.w2(), learnedClause);
         lastLearnedClause = learnedClause;
+        if (Config::statistics) {
+            stats.learnedClauses++;
+        }
     } else {
         DBGPRINT("learned single literal clause " << lastLiteral);
+        if (Config::statistics) {
+            stats.learnedClauses++;
+        }
     }
-    // unit propagation on the literal to make it true
-    propagationQueue.push_back(lastLiteral);
     // backtrack to second highest level
     int backtrackLevel = 0;
     if (!confLitLowerLvl.empty()) {
-        backtrackLevel = assignment.level(*confLitLowerLvl.rbegin());
+        backtrackLevel = assignment.levelOf(*confLitLowerLvl.rbegin());
     }
     confLitCurrLvl.clear();
     confLitLowerLvl.clear();
     conflictLiterals.clear();
-    return backtrackLevel;
+    backtrack(backtrackLevel);
+    decision.bump(analyzedVariables, assignment);
+    decision.conflict(stats.conflicts);
+    analyzedVariables.clear();
+    // xor rows checked again on backtracking may have implied the literal
+    if (assignment.isFalse(lastLiteral)) {
+        if (reason != nullptr) {
+            markConflict(*reason);
+        } else {
+            setUnsatisfiable();
+        }
+    } else if (!assignment.isAssigned(lastLiteral)) {
+        assign(lastLiteral, reason);
+    }
 }
 
-void sat::Solver::backtrack(int level)
+template <class Config>
+void sat::Solver<Config>::backtrack(int level)
 {
     DBGPRINT("backtracking to level " << level);
-    assignment.backtrackTo(level);
+    const std::vector<Literal>& trail = assignment.trailLiterals();
+    if (cardinality) {
+        // only the literals propagated so far are counted
+        for (std::size_t i = assignment.levelEnd(level); i < qhead; i++) {
+            cardinality->unassigned(trail[i]);
+        }
+    }
+    for (std::size_t i = assignment.levelEnd(level); i < trail.size(); i++) {
+        decision.unassigned(trail[i].id());
+    }
+    assignment.cancelUntil(level);
+    qhead = std::min(qhead, trail.size());
     clearConflict();
+    if (gauss) {
+        gauss->backtrack(level, implications);
+        enqueueImplications();
+    }
 }
 
-void sat::Solver::makeDecision()
+template <class Config>
+void sat::Solver<Config>::makeDecision()
 {
-    int v;
-    for (v = 1; v <= formula.numVariables(); v++) {
-        if (!assignment.isAssigned(Literal(v))) {
-            break;
+    while (assignment.currentLevel() < static_cast<int>(assumptions.size())) {
+        const Literal t = assumptions[assignment.currentLevel()];
+        if (assignment.isFalse(t)) {
+            analyzeFinal(t);
+            return;
+        } else if (!assignment.isTrue(t)) {
+            decide(t);
+            return;
         }
+        assignment.newLevel();
     }
-    Literal t(v);
-    DBGPRINT("decision on " << v);
-    assignment.decide(t);
-    updateWatches(t.negate());
+    if (assignment.allAssigned()) {
+        return;
+    }
+    decide(decision.pick(assignment));
 }
 
-void sat::Solver::unitPropagation()
+template <class Config>
+void sat::Solver<Config>::decide(const Literal& t)
 {
-    while (!propagationQueue.empty()) {
-        Literal t = propagationQueue.front();
+    DBGPRINT("decision on " << t);
+    if (Config::statistics) {
+        stats.decisions++;
+    }
+    assignment.setDecision(t);
+    reasons[t.id()] = {nullptr, -1};
+}
+
+// the literals on the trail from qhead on, assigned but not yet propagated
+template <class Config>
+void sat::Solver<Config>::unitPropagation()
+{
+    const std::vector<Literal>& trail = assignment.trailLiterals();
+    while (qhead < trail.size() && !hasConflict) {
+        // assignments during propagation can move the trail
+        const Literal t = trail[qhead++];
         DBGPRINT("propagating " << t);
-        if (!assignment.isAssigned(t)) {
-            assertLiteral(t);
+        updateWatches(t.negate());
+        propagateXors(t);
+        propagateCardinality(t);
+    }
+}
+
+template <class Config>
+std::size_t sat::Solver<Config>::memoryUsage() const
+{
+    // hash map nodes hold a key, a value and about two pointers,
+    // vector growth can double the watch list entries
+    const std::size_t node = sizeof(Literal) + 2 * sizeof(void*);
+    return memoryBaseline + formula.memoryUsage() + assignment.memoryUsage()
+        + 2 * watchEntries * sizeof(ClauseRef)
+        + watchList.size() * (node + sizeof(ClauseList))
+        + reasons.capacity() * sizeof(Reason) + decision.memoryUsage()
+        + (localSearch ? localSearch->memoryUsage() : 0);
+}
+
+template <class Config>
+void sat::Solver<Config>::checkMemory()
+{
+    // learned clauses are reduced once the memory used is above 3/4 of the
+    // limit, at most every REDUCE_INTERVAL conflicts unless over the limit
+    const std::size_t used = memoryUsage();
+    if (used > memoryLimit) {
+        reduceLearnedClauses();
+        if (memoryUsage() > memoryLimit) {
+            memoryOut = true;
         }
-        if (hasConflict) {
-            break;
+    } else if (used > memoryLimit / 4 * 3
+               && stats.conflicts - lastReduction >= REDUCE_INTERVAL) {
+        reduceLearnedClauses();
+    }
+}
+
+// deletes the longer half of the learned clauses that are not binary
+// and cannot be a reason, then compacts the watch lists
+template <class Config>
+void sat::Solver<Config>::reduceLearnedClauses()
+{
+    stats.reductions++;
+    lastReduction = stats.conflicts;
+    std::unordered_set<const Clause*> locked;
+    for (const Literal& t: assignment.trailLiterals()) {
+        if (reasons[t.id()].clause != nullptr) {
+            locked.insert(reasons[t.id()].clause);
+        }
+    }
+
+    std::vector<const Clause*> candidates;
+    int index = 0;
+    for (const Clause& clause: formula) {
+        if (index++ >= numOriginalClauses && clause.size() > 2
+                && locked.find(&clause) == locked.end()
+                && addedClauses.find(&clause) == addedClauses.end()) {
+            candidates.push_back(&clause);
+        }
+    }
+    auto middle = candidates.begin() + candidates.size() / 2;
+    std::nth_element(candidates.begin(), middle, candidates.end(),
+            [](const Clause* c1, const Clause* c2) { return c1->size() > c2->size(); });
+    const std::unordered_set<const Clause*> deleted(candidates.begin(), middle);
+    if (deleted.empty()) {
+        return;
+    }
+
+    watchEntries = 0;
+    for (auto& pair: watchList) {
+        ClauseList& clauses = pair.second;
+        clauses.erase(std::remove_if(clauses.begin(), clauses.end(),
+                    [&](const ClauseRef& c) { return deleted.find(&c.get()) != deleted.end(); }),
+                clauses.end());
+        clauses.shrink_to_fit();
+        watchEntries += clauses.size();
+    }
+    formula.removeClauses(numOriginalClauses, [&](const Clause& clause) {
+        if (deleted.find(&clause) == deleted.end()) {
+            return false;
+        }
+        if (Config::proof && proof != nullptr) {
+            proof->remove(clause);
+        }
+        return true;
+    });
+    stats.deletedClauses += deleted.size();
+    DBGPRINT("deleted " << deleted.size() << " learned clauses");
+}
+
+template <class Config>
+void sat::Solver<Config>::solveLocally()
+{
+    LocalSearch search(formula, formula.numClauses(), 0);
+    std::vector<bool> values(formula.numVariables() + 1);
+    for (int v = 1; v <= formula.numVariables(); v++) {
+        values[v] = assignment.savedPhase(v);
+    }
+    search.reset(values);
+    bool found = false;
+    while (!found && !stopped()) {
+        found = search.run(LOCAL_SEARCH_FLIPS);
+        poll();
+    }
+    stats.flips = search.flips();
+    if (found) {
+        setSatisfiable(std::vector<bool>(search.best().begin() + 1, search.best().end()));
+    }
+}
+
+// restarts, and seeds the saved phases with the best values local search
+// finds starting from them; a model found on the way is the result; learned
+// clauses are implied, so the search is only over the clauses before them
+template <class Config>
+void sat::Solver<Config>::rephase()
+{
+    backtrack(0);
+    const int numVars = formula.numVariables();
+    std::vector<bool> values(numVars + 1);
+    for (int v = 1; v <= numVars; v++) {
+        const Literal t(v);
+        values[v] = assignment.isAssigned(t) ? assignment.isTrue(t) : assignment.savedPhase(v);
+    }
+    if (!localSearch || localSearch->numVariables() != numVars) {
+        localSearch = std::make_unique<LocalSearch>(formula, numOriginalClauses, stats.rephases);
+        if (cardinality) {
+            // the clauses replaced by cardinality constraints
+            for (const std::vector<Literal>& clause: cardinality->encoding()) {
+                localSearch->addClause(clause);
+            }
+        }
+    }
+    LocalSearch& search = *localSearch;
+    search.reset(values);
+    const bool found = search.run(LOCAL_SEARCH_FLIPS);
+    stats.flips += search.flips();
+    DBGPRINT("local search left " << search.bestUnsatisfied() << " clauses unsatisfied");
+    // selectors let local search satisfy any formula by disabling clauses;
+    // a model is only a result under the assumptions
+    if (found && !models && !optimizing && coreOut == nullptr
+            && std::all_of(assumptions.begin(), assumptions.end(),
+                [&](const Literal& t) { return search.best()[t.id()] == t.polarity(); })) {
+        setSatisfiable(std::vector<bool>(search.best().begin() + 1, search.best().end()));
+    } else {
+        for (int v = 1; v <= numVars; v++) {
+            assignment.setSavedPhase(v, search.best()[v]);
+        }
+    }
+    // on a geometric schedule, local search costs a bounded share of the time
+    nextRephase = stats.conflicts + (REPHASE_INTERVAL << stats.rephases);
+    restarts.restarted(stats.conflicts, decision.inStableMode());
+    stats.rephases++;
+}
+
+template <class Config>
+void sat::Solver<Config>::restart()
+{
+    backtrack(0);
+    restarts.restarted(stats.conflicts, decision.inStableMode());
+    stats.restarts++;
+    if (!checkpointPath.empty() && std::chrono::steady_clock::now() >= nextCheckpoint) {
+        saveCheckpoint();
+        nextCheckpoint = std::chrono::steady_clock::now() + std::chrono::seconds(CHECKPOINT_SECONDS);
+    }
+}
+
+// pairwise encodings left by the cardinality constraints, and other
+// products of literals and clause remainders, are reencoded with fresh
+// variables; not with a proof, which would need their RAT steps
+template <class Config>
+void sat::Solver<Config>::reencode()
+{
+    if (Config::proof && proof != nullptr) {
+        return;
+    }
+    const int numVars = formula.numVariables();
+    const std::uint64_t maxSteps = std::min(BVA_STEPS,
+            BVA_STEPS_PER_CLAUSE * static_cast<std::uint64_t>(formula.numClauses()));
+    stats.reencodedClauses = boundedVariableAddition(formula,
+            [&]() { return newVariable(); }, maxSteps, [this] { return pollStopped(); });
+    stats.addedVariables = formula.numVariables() - numVars;
+    numOriginalClauses = formula.numClauses();
+    DBGPRINT("added " << stats.addedVariables << " variables removing "
+            << stats.reencodedClauses << " clauses");
+}
+
+// xors are found in the clauses, and propagated by Gauss-Jordan elimination;
+// its reasons are not DRAT steps, so it is not used with a proof
+template <class Config>
+void sat::Solver<Config>::initXors()
+{
+    if (Config::proof && proof != nullptr) {
+        return;
+    }
+    const std::vector<Xor> xors = findXors(formula, MAX_XOR_SIZE);
+    stats.xors = xors.size();
+    if (xors.empty()) {
+        return;
+    }
+    gauss = std::make_unique<Gauss>(xors, assignment);
+    DBGPRINT("found " << xors.size() << " xors, " << gauss->numRows() << " independent");
+    if (gauss->inconsistent()) {
+        setUnsatisfiable();
+        return;
+    }
+    gauss->propagateAll(implications);
+    enqueueImplications();
+}
+
+template <class Config>
+void sat::Solver<Config>::propagateXors(const Literal& t)
+{
+    if (!gauss || hasConflict) {
+        return;
+    }
+    const Clause* conflict = gauss->assigned(t, implications);
+    if (conflict != nullptr) {
+        DBGPRINT("xor conflict " << *conflict);
+        markConflict(*conflict);
+        implications.clear();
+        return;
+    }
+    enqueueImplications();
+}
+
+template <class Config>
+void sat::Solver<Config>::enqueueImplications()
+{
+    for (const Gauss::Implication& implication: implications) {
+        if (!assignment.isAssigned(implication.literal)) {
+            DBGPRINT("reason for propagating " << implication.literal << ": " << *implication.reason);
+            assign(implication.literal, implication.reason);
+        }
+    }
+    implications.clear();
+}
+
+// at-most-k constraints replace the clauses encoding them; explanations are
+// built from the same literals, so the clauses stay valid for a proof
+template <class Config>
+void sat::Solver<Config>::initCardinality()
+{
+    std::unordered_set<const Clause*> covered;
+    std::vector<AtMostK> constraints = findAtMostK(formula, MAX_CARDINALITY, covered,
+            [this] { return pollStopped(); });
+    if (constraints.empty()) {
+        return;
+    }
+    stats.cardinalities = constraints.size();
+    stats.replacedClauses = formula.removeClauses(0, [&](const Clause& clause) {
+        return covered.find(&clause) != covered.end();
+    });
+    numOriginalClauses -= stats.replacedClauses;
+    DBGPRINT("found " << constraints.size() << " cardinality constraints replacing "
+            << stats.replacedClauses << " clauses");
+    cardinality = std::make_unique<Cardinality>(std::move(constraints), assignment);
+    // the literals assigned so far are counted as the trail is propagated
+}
+
+// counts are updated for every assigned literal, also after a conflict
+template <class Config>
+void sat::Solver<Config>::propagateCardinality(const Literal& t)
+{
+    if (!cardinality) {
+        return;
+    }
+    enqueueCardinality(cardinality->assigned(t, cardinalityImplications));
+}
+
+template <class Config>
+void sat::Solver<Config>::enqueueCardinality(const bool consistent)
+{
+    if (hasConflict) {
+        cardinalityImplications.clear();
+        return;
+    }
+    if (!consistent) {
+        std::vector<Literal> literals(cardinality->conflict());
+        cardinalityConflict = Clause(literals);
+        DBGPRINT("cardinality conflict " << cardinalityConflict);
+        markConflict(cardinalityConflict);
+        cardinalityImplications.clear();
+        return;
+    }
+    for (const Cardinality::Implication& implication: cardinalityImplications) {
+        if (!assignment.isAssigned(implication.literal)) {
+            DBGPRINT("reason for propagating " << implication.literal
+                    << ": constraint " << implication.constraint);
+            assign(implication.literal, nullptr);
+            reasons[implication.literal.id()].constraint = implication.constraint;
+        }
+    }
+    cardinalityImplications.clear();
+}
+
+// the assumption t is false, the decisions its negation follows from are
+// assumptions; the search ends with t and them in core
+template <class Config>
+void sat::Solver<Config>::analyzeFinal(const Literal& t)
+{
+    core.assign(1, t);
+    std::vector<char> seen(formula.numVariables() + 1, 0);
+    seen[t.id()] = 1;
+    std::vector<Literal> explanation;
+    const std::vector<Literal>& trail = assignment.trailLiterals();
+    for (std::size_t i = trail.size(); i-- > assignment.levelEnd(0);) {
+        const Literal& x = trail[i];
+        if (!seen[x.id()]) {
+            continue;
+        }
+        if (assignment.isDecision(x)) {
+            core.push_back(x);
+            continue;
         }
-        propagationQueue.pop_front();
+        explanation.clear();
+        const Reason& reason = reasons[x.id()];
+        if (reason.clause != nullptr) {
+            explanation.assign(reason.clause->begin(), reason.clause->end());
+        } else {
+            cardinality->explain(x, reason.constraint, explanation);
+        }
+        for (const Literal& y: explanation) {
+            if (assignment.levelOf(y) > 0) {
+                seen[y.id()] = 1;
+            }
+        }
+    }
+    DBGPRINTC("core ", core);
+    result = Result::Unsatisfiable;
+}
+
+template <class Config>
+int sat::Solver<Config>::newVariable()
+{
+    assignment.addVariable();
+    reasons.push_back({nullptr, -1});
+    decision.addVariables(assignment.total());
+    return formula.addVariable();
+}
+
+// a hard clause added at level 0, without the literals false there
+template <class Config>
+void sat::Solver<Config>::addClause(const std::vector<Literal>& literals)
+{
+    Clause* clause = attachClause(literals);
+    if (clause != nullptr) {
+        addedClauses.insert(clause);
+    }
+}
+
+// a clause watched from level 0 on, without the literals false there;
+// nullptr if it is true, a unit, which is assigned, or empty
+template <class Config>
+sat::Clause* sat::Solver<Config>::attachClause(const std::vector<Literal>& literals)
+{
+    std::vector<Literal> unassigned;
+    for (const Literal& t: literals) {
+        if (assignment.isTrue(t)) {
+            return nullptr;
+        } else if (!assignment.isAssigned(t)) {
+            unassigned.push_back(t);
+        }
+    }
+    if (unassigned.empty()) {
+        // no core without the assumptions
+        setUnsatisfiable();
+        core.clear();
+    } else if (unassigned.size() == 1) {
+        assign(unassigned[0], nullptr);
+    } else {
+        Clause& clause = formula.addClause(Clause(unassigned));
+        addToWatchList(clause.w1(), clause);
+        addToWatchList(clause.w2(), clause);
+        return &clause;
+    }
+    return nullptr;
+}
+
+namespace sat
+{
+    template class Solver<DefaultConfig<false, false>>;
+    template class Solver<DefaultConfig<false, true>>;
+    template class Solver<DefaultConfig<true, false>>;
+    template class Solver<DefaultConfig<true, true>>;
+}
+
+std::unique_ptr<sat::BaseSolver> sat::makeSolver(Formula&& formula, const bool proof,
+        const bool statistics)
+{
+    if (proof) {
+        if (statistics) {
+            return std::make_unique<Solver<DefaultConfig<true, true>>>(std::move(formula));
+        }
+        return std::make_unique<Solver<DefaultConfig<true, false>>>(std::move(formula));
+    }
+    if (statistics) {
+        return std::make_unique<Solver<DefaultConfig<false, true>>>(std::move(formula));
     }
-    // conflict
-    propagationQueue.clear();
+    return std::make_unique<Solver<DefaultConfig<false, false>>>(std::move(formula));
 }
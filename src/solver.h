@@ -5,68 +5,394 @@
 #include "clause.h"
 #include "assignment.h"
 #include "formula.h"
+#include "proof.h"
+#include "budget.h"
+#include "checkpoint.h"
+#include "gauss.h"
+#include "cardinality.h"
+#include "localsearch.h"
+#include "models.h"
+#include "totalizer.h"
+#include "policy.h"
+#include <array>
+#include <chrono>
+#include <string>
 #include <vector>
 #include <stack>
-#include <deque>
 #include <set>
 #include <unordered_set>
+#include <unordered_map>
 #include <functional>
+#include <future>
+#include <iostream>
+#include <cstdint>
+#include <memory>
 
 namespace sat
 {
     enum class Result { Satisfiable, Unsatisfiable, Unknown };
     std::ostream& operator<<(std::ostream& out, const Result& v);
 
+    struct Statistics
+    {
+        std::uint64_t decisions = 0;
+        std::uint64_t conflicts = 0;
+        std::uint64_t propagations = 0;
+        std::uint64_t learnedClauses = 0;
+        std::uint64_t deletedClauses = 0;
+        std::uint64_t reductions = 0;
+        std::uint64_t restarts = 0;
+        std::uint64_t rephases = 0;
+        std::uint64_t flips = 0;
+        std::uint64_t xors = 0;
+        std::uint64_t cardinalities = 0;
+        std::uint64_t replacedClauses = 0;
+        std::uint64_t addedVariables = 0;
+        std::uint64_t reencodedClauses = 0;
+    };
+    std::ostream& operator<<(std::ostream& out, const Statistics& s);
+
+    // the result of BaseSolver::solveAsync
+    struct Outcome
+    {
+        Result result;
+        // values of variables 1 to n when satisfiable, fresh ones included
+        std::vector<bool> model;
+        // of the best model, for soft clauses
+        std::uint64_t cost;
+        Statistics stats;
+    };
+
+    // the cubes of BaseSolver::solveCubes, and where their results go
+    class CubeSource
+    {
+    public:
+        virtual ~CubeSource() = default;
+        // false when there are no more cubes; the clauses, implied by the
+        // formula, are added before the cube is solved
+        virtual bool next(std::vector<Literal>& cube, std::vector<std::vector<Literal>>& clauses) = 0;
+        // the result under the last cube, the model if satisfiable, and the
+        // short clauses over input variables learned since the cube before
+        virtual void finished(const Result result, const std::vector<bool>& model,
+                const std::vector<std::vector<Literal>>& learned) = 0;
+    };
+
     class BaseSolver
     {
     public:
+        virtual ~BaseSolver() = default;
         virtual void solve(const int timeLimitSeconds, const bool verbose) = 0;
+        // solves on a thread of its own, printing nothing but to the streams
+        // given to setEnumeration, setCore and setBackbone, which it writes
+        // from that thread; the solver must not be used otherwise until the
+        // future is ready, which it waits for when destroyed, but may be
+        // cancelled from any thread; solvers share no state, so several may
+        // run at once
+        virtual std::future<Outcome> solveAsync(const int timeLimitSeconds) = 0; // can throw
+        Result getResult() const { return result; }
+        // values of variables 1 to n when satisfiable, fresh ones included
+        const std::vector<bool>& getModel() const { return model; }
+        // async-signal-safe, the solve stops with unknown
         virtual void cancel() = 0;
+        // polled at every conflict, and every few hundred steps between
+        // them, on the solving thread; once it returns true, the solve stops
+        // with unknown
+        virtual void setTermination(std::function<bool()> terminate) = 0;
+        // called on the solving thread every interval conflicts; counters
+        // other than conflicts are only counted by solvers with statistics
+        virtual void setProgress(std::function<void(const Statistics&)> progress,
+                const std::uint64_t interval) = 0;
+        // solving stops with unknown after this many conflicts or
+        // propagations, the latter only counted with statistics
+        virtual void setConflictLimit(const std::uint64_t conflicts) = 0;
+        virtual void setPropagationLimit(const std::uint64_t propagations) = 0; // can throw
+        // DRAT proof of unsatisfiability is written to proof, if set
+        virtual void setProof(Proof* proof) = 0; // can throw
+        // solving stops with unknown when memory would exceed the limit
+        virtual void setMemoryLimit(const std::size_t megabytes) = 0;
+        // only local search is run, which cannot show unsatisfiability;
+        // otherwise it is interleaved with CDCL to seed the saved phases
+        virtual void setLocalSearchOnly(const bool enabled) = 0;
+        // every model over the projected variables is written to out, all
+        // input variables when projection is empty; variables must exist
+        virtual void setEnumeration(std::ostream& out, const std::vector<int>& projection) = 0;
+        // the total weight of the falsified soft clauses is minimized, the
+        // formula holding the hard clauses; improved bounds are printed
+        virtual void setSoftClauses(std::vector<SoftClause>&& clauses) = 0;
+        // learned clauses, level 0 units, phases, activities and counters
+        // are saved to path when the solve stops with unknown, and
+        // periodically at restarts; replaced atomically; set before solving
+        virtual void setCheckpoint(const std::string& path) = 0;
+        // the solve continues from the checkpoint at path, which must have
+        // been saved for the same formula; set before solving
+        virtual void resume(const std::string& path) = 0; // can throw
+        // the saved phases start at the hinted values, and hinted variables
+        // are decided first; before preprocessing, the hint is repaired by
+        // local search, and after it, extended to a model by decisions with
+        // propagation, leaving out the literals that conflict; variables
+        // must exist
+        virtual void setHint(const std::vector<Literal>& literals) = 0;
+        // when the result is unsatisfiable, a subset of the clauses that is
+        // unsatisfiable too is written to out in DIMACS; with minimize, until
+        // leaving out any one of them makes it satisfiable, or time runs out
+        virtual void setCore(std::ostream& out, const bool minimize) = 0;
+        // when the result is satisfiable, the literals true in every model,
+        // over input variables, are written to out as a line b literals 0;
+        // only those confirmed so far when a limit is reached
+        virtual void setBackbone(std::ostream& out) = 0;
+        // before the search, variables are renumbered and clauses laid out
+        // for locality, in Cuthill-McKee order; models, hints and printed
+        // literals are in the numbering of the input
+        virtual void setReordering(const bool enabled) = 0;
+        // instead of solve, solves the formula under one cube after another,
+        // keeping learned clauses between them; nothing is printed, and pure
+        // literals are kept, since the cubes may falsify them
+        virtual void solveCubes(CubeSource& cubes, const int timeLimitSeconds) = 0;
+
+    protected:
+        Result result = Result::Unknown;
+        std::vector<bool> model;
     };
 
+    // the solver of one of a fixed set of configurations, proof logging
+    // and statistics only if asked for; statistics are printed if verbose
+    std::unique_ptr<BaseSolver> makeSolver(Formula&& formula, const bool proof,
+            const bool statistics);
+
+    // drives private steps of the solver in isolation, for microbenchmarks
+    struct SolverKernels;
+
+    // defined in solver.cpp, and the members of a feature in a file of its
+    // own, each instantiated there for the configurations makeSolver picks
+    template <class Config>
     class Solver : public BaseSolver
     {
     public:
         explicit Solver(Formula&& formula);
         virtual void solve(const int timeLimitSeconds, const bool verbose);
+        virtual std::future<Outcome> solveAsync(const int timeLimitSeconds);
         virtual void cancel();
+        virtual void setTermination(std::function<bool()> terminate);
+        virtual void setProgress(std::function<void(const Statistics&)> progress,
+                const std::uint64_t interval);
+        virtual void setConflictLimit(const std::uint64_t conflicts);
+        virtual void setPropagationLimit(const std::uint64_t propagations);
+        virtual void setProof(Proof* proof);
+        virtual void setMemoryLimit(const std::size_t megabytes);
+        virtual void setLocalSearchOnly(const bool enabled);
+        virtual void setEnumeration(std::ostream& out, const std::vector<int>& projection);
+        virtual void setSoftClauses(std::vector<SoftClause>&& clauses);
+        virtual void setCheckpoint(const std::string& path);
+        virtual void resume(const std::string& path);
+        virtual void solveCubes(CubeSource& cubes, const int timeLimitSeconds);
+        virtual void setCore(std::ostream& out, const bool minimize);
+        virtual void setHint(const std::vector<Literal>& literals);
+        virtual void setBackbone(std::ostream& out);
+        virtual void setReordering(const bool enabled);
 
     private:
+        void run(const int timeLimitSeconds, std::ostream* output);
+        void solveFormula();
+        void renumber();
+        Literal original(const Literal& t) const;
+        void poll();
         void unitPropagation();
         void pureLiteralElimination();
+        void propagateUnits();
         void processSingleLiteralClauses();
         void makeDecision();
+        void decide(const Literal& t);
         void backtrack(int level);
-        void assertLiteral(const Literal& t);
+        void assign(const Literal& t, const Clause* reason);
         void updateWatches(const Literal& t);
         void addToWatchList(const Literal& t, Clause& clause);
-        int analyzeConflict();
+        void analyzeConflict();
         void markConflict(const Clause& clause);
         void clearConflict();
         void addLiterals(const Clause& clause);
-        void setReason(const Literal& t, const Clause& clause);
         void printResult(const bool verbose);
+        void setUnsatisfiable();
+        void setSatisfiable(const std::vector<bool>& values);
+        void solveLocally();
+        void rephase();
+        void restart();
+        void initXors();
+        void propagateXors(const Literal& t);
+        void enqueueImplications();
+        void initCardinality();
+        void reencode();
+        void propagateCardinality(const Literal& t);
+        void enqueueCardinality(const bool consistent);
+        std::size_t memoryUsage() const;
+        void checkMemory();
+        void reduceLearnedClauses();
+        void blockModel();
+        void search();
+        bool stopped();
+        bool pollStopped();
+        void analyzeFinal(const Literal& t);
+        int newVariable();
+        void addClause(const std::vector<Literal>& literals);
+        Clause* attachClause(const std::vector<Literal>& literals);
+        std::array<std::uint64_t*, 9> savedCounters();
+        void saveCheckpoint();
+        void restore(const Checkpoint& checkpoint);
+        void optimize();
+        void addSelectors();
+        void seedHint();
+        void repairHint();
+        void tryHint();
+        void findCore();
+        void writeCore();
+        void findBackbone();
+        void writeBackbone();
+        void processCore(std::uint64_t& lowerBound);
+        std::uint64_t cost(const std::vector<bool>& values) const;
 
         Formula formula;
-        Result result = Result::Unknown;
-        bool canceled = false;
+        // of the formula as given, identifies it in checkpoints; only
+        // computed when they are used, before preprocessing changes it
+        std::uint64_t formulaHash = 0;
+        Budget budget;
+        Proof* proof = nullptr;
+        Statistics stats;
+
+        static const std::uint64_t LOCAL_SEARCH_FLIPS = 100000;
+        // of rephase, over the clauses before learning; made at the first
+        // rephase, and again if variables were added since
+        std::unique_ptr<LocalSearch> localSearch;
+        static const std::uint64_t REPHASE_INTERVAL = 1000;
+        bool localSearchOnly = false;
+        // where results and bounds are printed, set by run: none for solveAsync
+        std::ostream* output = nullptr;
+        std::function<bool()> terminate;
+        static const std::uint64_t TERMINATION_INTERVAL = 256;
+        std::uint64_t terminationChecks = 0;
+        std::function<void(const Statistics&)> progress;
+        std::uint64_t progressInterval = 0;
+        std::uint64_t nextProgress = 0;
+        std::uint64_t nextRephase = 0;
+        typename Config::Decision decision;
+        typename Config::Restarts restarts;
+        // variables above level 0 in the clauses of the last conflict analysis
+        std::vector<int> analyzedVariables;
+
+        static const int MAX_XOR_SIZE = 6;
+        std::unique_ptr<Gauss> gauss;
+        std::vector<Gauss::Implication> implications;
+
+        // clauses blocking enumerated models, or of totalizers, are kept
+        // like original ones
+        std::unique_ptr<ModelWriter> models;
+        std::vector<char> projected;
+        std::unordered_set<const Clause*> addedClauses;
+
+        static const int CHECKPOINT_SECONDS = 60;
+        std::string checkpointPath;
+        std::chrono::steady_clock::time_point nextCheckpoint;
+        std::unique_ptr<Checkpoint> resumed;
+
+        // decided first, one level each; a falsified one ends the search
+        // with the assumptions implying its negation in core
+        std::vector<Literal> assumptions;
+        std::vector<Literal> core;
+
+        // for a core, every input clause has a fresh selector variable,
+        // from firstSelector on, whose negation is added to it; assumed
+        // true, the assumptions of a refutation select a core
+        std::ostream* coreOut = nullptr;
+        bool minimizeCore = false;
+        int firstSelector = 0;
+        std::vector<std::vector<Literal>> inputClauses;
+
+        std::vector<Literal> hint;
+
+        bool reordering = false;
+        // of each renumbered variable, empty unless renumbered
+        std::vector<int> originalVariables;
+
+        // the literals of every model found so far are candidates, and
+        // those whose negation is refuted are confirmed
+        std::ostream* backboneOut = nullptr;
+        std::vector<Literal> backbone;
+        std::size_t uncheckedCandidates = 0;
+
+        // reencoding visits at most this many clauses per clause, and in all
+        static const std::uint64_t BVA_STEPS_PER_CLAUSE = 100;
+        static const std::uint64_t BVA_STEPS = 100000000;
+
+        // setup passes over the clauses run in parallel, a part each
+        static const int MIN_PART_CLAUSES = 1 << 16;
+        static int partBegin(const int size, const int parts, const int i)
+        {
+            return static_cast<int>(static_cast<std::int64_t>(size) * i / parts);
+        }
+
+        // learned clauses given to solveCubes, short ones over input
+        // variables, which other solvers of the formula can use
+        static const std::size_t MAX_SHARED_SIZE = 4;
+        static const std::size_t MAX_SHARED_CLAUSES = 1000;
+        bool sharing = false;
+        std::vector<std::vector<Literal>> sharedClauses;
+
+        static const int MAX_CARDINALITY = 3;
+        std::unique_ptr<Cardinality> cardinality;
+        std::vector<Cardinality::Implication> cardinalityImplications;
+        Clause cardinalityConflict = Clause(std::vector<int>());
+
+        static const std::size_t MEGABYTE = 1 << 20;
+        static const std::uint64_t REDUCE_INTERVAL = 2000;
+        std::size_t memoryLimit = 0;
+        // memory not accounted for by the solver, measured at start
+        std::size_t memoryBaseline = 0;
+        bool memoryOut = false;
+        std::uint64_t lastReduction = 0;
+        // clauses after these are learned
+        int numOriginalClauses;
+        std::size_t watchEntries = 0;
 
         Assignment assignment;
 
         template <class T> using LiteralMap = std::unordered_map<Literal, T>;
+
+        // core-guided MaxSAT, OLL: every soft clause has an assumption
+        // literal, itself for unit clauses; a core of them raises the lower
+        // bound by its lowest weight, and a totalizer over the core bounds
+        // how many of them may be false, its outputs becoming assumptions
+        struct Sum
+        {
+            int totalizer;
+            int bound;
+        };
+        bool optimizing = false;
+        std::vector<SoftClause> softClauses;
+        std::vector<Literal> softLiterals;
+        LiteralMap<std::uint64_t> softWeights;
+        LiteralMap<Sum> sums;
+        std::vector<Totalizer> totalizers;
+        std::uint64_t bestCost = 0;
+
         using ClauseRef = std::reference_wrapper<Clause>;
-        using ConstClauseRef = std::reference_wrapper<const Clause>;
         using ClauseList = std::vector<ClauseRef>;
 
         LiteralMap<ClauseList> watchList;
-        LiteralMap<ConstClauseRef> upReasons;
-        std::deque<Literal> propagationQueue;
+        // indexed by variable, set when it is assigned: the clause implying
+        // it, or the cardinality constraint whose explanation, built on
+        // demand, is the reason; neither for decisions and level 0 units
+        struct Reason
+        {
+            const Clause* clause;
+            int constraint;
+        };
+        std::vector<Reason> reasons;
+        // trail position of the next literal to propagate
+        std::size_t qhead = 0;
 
         struct LiteralComparator {
             const Assignment& assignment;
             explicit LiteralComparator(const Assignment& assignment): assignment(assignment) {}
             bool operator()(const Literal& t1, const Literal& t2) const {
-                return assignment.isBefore(t1, t2);
+                return assignment.precedes(t1, t2);
             }
         };
         LiteralComparator comparator;
@@ -77,7 +403,12 @@ namespace sat
         bool hasConflict = false;
         const Clause* conflictClause;
         Clause lastLearnedClause = Clause(std::vector<int>());
+        friend struct SolverKernels;
     };
+
+    // the configurations makeSolver picks from
+    template <bool proof, bool statistics>
+    using DefaultConfig = Config<ModeSwitchingDecision, LubyRestarts, proof, statistics>;
 }
 
 #endif // SAT_SOLVER_H
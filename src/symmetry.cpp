@@ -0,0 +1,464 @@
+
+#include "symmetry.h"
+#include "debug.h"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <queue>
+
+namespace
+{
+    // partitions kept along the first path, in vertices times levels
+    const std::size_t MAX_PATH_ENTRIES = 1 << 22;
+    // refinement work, in adjacencies and cell elements visited, so that
+    // the symmetries found do not depend on the machine
+    const std::uint64_t MAX_STEPS = 50000000;
+    const std::uint64_t POLL_SPLITS = 256;
+    // positions of a lex-leader constraint, the first ones prune the most
+    const int MAX_BREAKING_LENGTH = 100;
+
+    // vertex 2 * (v - 1) + sign for the literals of variable v, followed by
+    // a vertex for each clause; a literal is adjacent to its complement and
+    // to its clauses, the literals of a clause are sorted
+    struct Graph
+    {
+        int numVertices;
+        int numLiteralVertices;
+        std::vector<int> start;
+        std::vector<int> adjacent;
+
+        explicit Graph(const sat::Formula& formula)
+        {
+            numLiteralVertices = 2 * formula.numVariables();
+            numVertices = numLiteralVertices + formula.numClauses();
+            std::vector<int> degree(numVertices, 1);
+            int c = numLiteralVertices;
+            for (const sat::Clause& clause: formula) {
+                degree[c++] = clause.size();
+                for (const sat::Literal& t: clause) {
+                    degree[t.index() - 2]++;
+                }
+            }
+            start.resize(numVertices + 1, 0);
+            for (int v = 0; v < numVertices; v++) {
+                start[v+1] = start[v] + degree[v];
+            }
+            adjacent.resize(start[numVertices]);
+            std::vector<int> fill(start.begin(), start.end() - 1);
+            for (int v = 0; v < numLiteralVertices; v++) {
+                adjacent[fill[v]++] = v ^ 1;
+            }
+            c = numLiteralVertices;
+            for (const sat::Clause& clause: formula) {
+                for (const sat::Literal& t: clause) {
+                    adjacent[fill[c]++] = t.index() - 2;
+                    adjacent[fill[t.index() - 2]++] = c;
+                }
+                c++;
+            }
+            for (c = numLiteralVertices; c < numVertices; c++) {
+                std::sort(adjacent.begin() + start[c], adjacent.begin() + start[c+1]);
+            }
+        }
+    };
+
+    // ordered partition of the vertices, cells are ranges of elements
+    struct Partition
+    {
+        std::vector<int> elements;
+        std::vector<int> position;
+        // start of the cell of each vertex
+        std::vector<int> cellOf;
+        // end of each cell, indexed by its start
+        std::vector<int> cellEnd;
+        int numCells = 0;
+
+        bool discrete() const { return numCells == static_cast<int>(elements.size()); }
+        int firstNonSingleton() const
+        {
+            int s = 0;
+            while (s < static_cast<int>(elements.size()) && cellEnd[s] == s + 1) {
+                s++;
+            }
+            return s;
+        }
+        bool sameShape(const Partition& other) const
+        {
+            if (numCells != other.numCells) {
+                return false;
+            }
+            for (std::size_t i = 0; i < elements.size(); i++) {
+                if (cellOf[elements[i]] != other.cellOf[other.elements[i]]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    // splits cells by the number of neighbors in a splitter cell until the
+    // partition is equitable; cells are split and splitters taken in an
+    // order that only depends on the ordered partition, so an automorphism
+    // mapping two partitions maps their refinements
+    class Refiner
+    {
+    public:
+        Refiner(const Graph& graph, const std::function<bool()>& stopped):
+            graph(graph), stopped(stopped),
+            count(graph.numVertices, 0), cellTouched(graph.numVertices, 0),
+            inQueue(graph.numVertices, 0)
+        {}
+
+        // cells of the vertices by color, in order of color
+        Partition initial(const std::vector<int>& color)
+        {
+            Partition p;
+            const int n = graph.numVertices;
+            p.elements.resize(n);
+            p.position.resize(n);
+            p.cellOf.resize(n);
+            p.cellEnd.resize(n);
+            for (int v = 0; v < n; v++) {
+                p.elements[v] = v;
+            }
+            std::stable_sort(p.elements.begin(), p.elements.end(),
+                    [&color](int v, int w) { return color[v] < color[w]; });
+            int a = 0;
+            for (int i = 0; i <= n; i++) {
+                if (i < n && color[p.elements[i]] == color[p.elements[a]]) {
+                    continue;
+                }
+                p.cellEnd[a] = i;
+                for (int j = a; j < i; j++) {
+                    p.position[p.elements[j]] = j;
+                    p.cellOf[p.elements[j]] = a;
+                }
+                p.numCells++;
+                push(a);
+                a = i;
+            }
+            return p;
+        }
+
+        // false if out of steps or stopped
+        bool individualize(Partition& p, const int v)
+        {
+            const int s = p.cellOf[v];
+            const int other = p.elements[s];
+            std::swap(p.elements[s], p.elements[p.position[v]]);
+            p.position[other] = p.position[v];
+            p.position[v] = s;
+            p.cellEnd[s + 1] = p.cellEnd[s];
+            p.cellEnd[s] = s + 1;
+            for (int i = s + 1; i < p.cellEnd[s + 1]; i++) {
+                p.cellOf[p.elements[i]] = s + 1;
+            }
+            p.numCells++;
+            push(s);
+            return refine(p);
+        }
+
+        // false if out of steps or stopped
+        bool refine(Partition& p)
+        {
+            while (!queue.empty()) {
+                const int s = queue.top();
+                queue.pop();
+                inQueue[s] = 0;
+                if (outOfSteps() || (++splits % POLL_SPLITS == 0 && stopped())) {
+                    clearQueue();
+                    return false;
+                }
+                split(p, s);
+            }
+            return true;
+        }
+
+        bool outOfSteps() const
+        {
+            return steps > MAX_STEPS;
+        }
+
+        // work outside of refinement, such as checking an image
+        void charge(const std::uint64_t work)
+        {
+            steps += work;
+        }
+
+    private:
+        void push(const int s)
+        {
+            if (!inQueue[s]) {
+                inQueue[s] = 1;
+                queue.push(s);
+            }
+        }
+
+        void clearQueue()
+        {
+            while (!queue.empty()) {
+                inQueue[queue.top()] = 0;
+                queue.pop();
+            }
+        }
+
+        void split(Partition& p, const int splitter)
+        {
+            for (int i = splitter; i < p.cellEnd[splitter]; i++) {
+                const int v = p.elements[i];
+                steps += graph.start[v+1] - graph.start[v];
+                for (int j = graph.start[v]; j < graph.start[v+1]; j++) {
+                    const int w = graph.adjacent[j];
+                    if (count[w]++ == 0) {
+                        touched.push_back(w);
+                        const int c = p.cellOf[w];
+                        if (!cellTouched[c]) {
+                            cellTouched[c] = 1;
+                            touchedCells.push_back(c);
+                        }
+                    }
+                }
+            }
+            std::sort(touchedCells.begin(), touchedCells.end());
+            for (int s: touchedCells) {
+                cellTouched[s] = 0;
+                const int e = p.cellEnd[s];
+                if (e - s == 1) {
+                    continue;
+                }
+                steps += e - s;
+                const int first = count[p.elements[s]];
+                if (std::all_of(p.elements.begin() + s + 1, p.elements.begin() + e,
+                            [&](int v) { return count[v] == first; })) {
+                    continue;
+                }
+                std::sort(p.elements.begin() + s, p.elements.begin() + e,
+                        [this](int v, int w) { return count[v] < count[w]; });
+                int a = s;
+                for (int i = s; i <= e; i++) {
+                    if (i < e && count[p.elements[i]] == count[p.elements[a]]) {
+                        continue;
+                    }
+                    // fragment [a, i)
+                    p.cellEnd[a] = i;
+                    for (int j = a; j < i; j++) {
+                        p.position[p.elements[j]] = j;
+                        p.cellOf[p.elements[j]] = a;
+                    }
+                    if (a != s) {
+                        p.numCells++;
+                    }
+                    push(a);
+                    a = i;
+                }
+            }
+            for (int w: touched) {
+                count[w] = 0;
+            }
+            touched.clear();
+            touchedCells.clear();
+        }
+
+        const Graph& graph;
+        const std::function<bool()>& stopped;
+        std::uint64_t steps = 0;
+        std::uint64_t splits = 0;
+        std::vector<int> count;
+        std::vector<int> touched;
+        std::vector<int> touchedCells;
+        std::vector<char> cellTouched;
+        std::vector<char> inQueue;
+        std::priority_queue<int, std::vector<int>, std::greater<int>> queue;
+    };
+
+    // image maps vertices to vertices of the same color, it is a symmetry
+    // if it respects complements and maps every clause to its image
+    bool isAutomorphism(const Graph& graph, const std::vector<int>& image,
+            std::vector<int>& mapped)
+    {
+        for (int v = 0; v < graph.numLiteralVertices; v++) {
+            if (image[v ^ 1] != (image[v] ^ 1)) {
+                return false;
+            }
+        }
+        for (int c = graph.numLiteralVertices; c < graph.numVertices; c++) {
+            const int d = image[c];
+            if (graph.start[c+1] - graph.start[c] != graph.start[d+1] - graph.start[d]) {
+                return false;
+            }
+            mapped.clear();
+            for (int j = graph.start[c]; j < graph.start[c+1]; j++) {
+                mapped.push_back(image[graph.adjacent[j]]);
+            }
+            std::sort(mapped.begin(), mapped.end());
+            if (!std::equal(mapped.begin(), mapped.end(), graph.adjacent.begin() + graph.start[d])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    int findOrbit(std::vector<int>& parent, int v)
+    {
+        while (parent[v] != v) {
+            parent[v] = parent[parent[v]];
+            v = parent[v];
+        }
+        return v;
+    }
+}
+
+std::vector<sat::Permutation> sat::findSymmetries(const Formula& formula,
+        const std::function<bool()>& stopped)
+{
+    std::vector<Permutation> generators;
+    const Graph graph(formula);
+    Refiner refiner(graph, stopped);
+    // literals that occur in no clause are fixed, their symmetries are of
+    // no use
+    std::vector<int> color(graph.numVertices, 0);
+    for (int v = 0; v < graph.numVertices; v++) {
+        if (v >= graph.numLiteralVertices) {
+            color[v] = 1;
+        } else if (graph.start[v+1] - graph.start[v] == 1) {
+            color[v] = 2 + v;
+        }
+    }
+    Partition root = refiner.initial(color);
+    if (!refiner.refine(root)) {
+        return generators;
+    }
+
+    // the first path individualizes the first vertex of the first
+    // non-singleton cell down to a discrete partition
+    std::vector<Partition> path;
+    std::vector<int> chosen;
+    Partition p = root;
+    while (!p.discrete()) {
+        if ((path.size() + 1) * graph.numVertices > MAX_PATH_ENTRIES) {
+            return generators;
+        }
+        path.push_back(p);
+        chosen.push_back(p.elements[p.firstNonSingleton()]);
+        if (!refiner.individualize(p, chosen.back())) {
+            return generators;
+        }
+    }
+    path.push_back(p);
+    const std::vector<int>& leaf = path.back().elements;
+
+    // from the deepest level up, every other vertex of the target cell not
+    // yet in the orbit of the chosen one is individualized instead and
+    // followed the same way; the leaves map by position, which is kept
+    // if it is a symmetry of the formula
+    std::vector<int> mapped;
+    std::vector<int> orbit(graph.numVertices);
+    for (int v = 0; v < graph.numVertices; v++) {
+        orbit[v] = v;
+    }
+    std::vector<int> image(graph.numVertices);
+    for (int level = static_cast<int>(chosen.size()) - 1; level >= 0; level--) {
+        const Partition& base = path[level];
+        const int target = base.cellOf[chosen[level]];
+        for (int i = target; i < base.cellEnd[target]; i++) {
+            const int w = base.elements[i];
+            if (findOrbit(orbit, w) == findOrbit(orbit, chosen[level])) {
+                continue;
+            }
+            if (refiner.outOfSteps() || stopped()) {
+                DBGPRINT("symmetry search out of steps");
+                return generators;
+            }
+            Partition q = base;
+            bool ok = refiner.individualize(q, w);
+            for (int l = level + 1; ok && l < static_cast<int>(path.size()); l++) {
+                ok = q.sameShape(path[l]);
+                if (ok && !q.discrete()) {
+                    ok = refiner.individualize(q, q.elements[q.firstNonSingleton()]);
+                }
+            }
+            if (!ok) {
+                continue;
+            }
+            for (int j = 0; j < graph.numVertices; j++) {
+                image[leaf[j]] = q.elements[j];
+            }
+            refiner.charge(graph.adjacent.size());
+            if (!isAutomorphism(graph, image, mapped)) {
+                continue;
+            }
+            Permutation permutation(graph.numLiteralVertices + 2);
+            permutation[0] = 0;
+            permutation[1] = 1;
+            for (int v = 0; v < graph.numLiteralVertices; v++) {
+                permutation[v + 2] = image[v] + 2;
+            }
+            for (int v = 0; v < graph.numVertices; v++) {
+                const int o1 = findOrbit(orbit, v), o2 = findOrbit(orbit, image[v]);
+                if (o1 != o2) {
+                    orbit[o1] = o2;
+                }
+            }
+            generators.push_back(std::move(permutation));
+        }
+    }
+    DBGPRINT("found " << generators.size() << " symmetry generators");
+    return generators;
+}
+
+int sat::breakSymmetries(Formula& formula, const std::vector<Permutation>& generators)
+{
+    // with e(i) meaning the first i variables equal their images,
+    // e(i-1) -> x(i) <= y(i), and e(i-1) and x(i) = y(i) -> e(i)
+    int added = 0;
+    std::vector<int> support;
+    std::vector<Literal> literals;
+    auto add = [&](std::initializer_list<Literal> clause) {
+        literals.assign(clause.begin(), clause.end());
+        formula.addClause(Clause(literals));
+        added++;
+    };
+    for (const Permutation& permutation: generators) {
+        support.clear();
+        const int numVars = permutation.size() / 2 - 1;
+        for (int v = 1; v <= numVars; v++) {
+            if (permutation[Literal(v).index()] != Literal(v).index()) {
+                support.push_back(v);
+            }
+        }
+        int equal = 0;
+        const int length = std::min<int>(support.size(), MAX_BREAKING_LENGTH);
+        for (int i = 0; i < length; i++) {
+            const Literal x(support[i]);
+            const Literal y = Literal::fromIndex(permutation[x.index()]);
+            if (y == x.negate()) {
+                // x has to be false, the images cannot be equal
+                if (equal == 0) {
+                    add({x.negate()});
+                } else {
+                    add({Literal(-equal), x.negate()});
+                }
+                break;
+            }
+            if (equal == 0) {
+                add({x.negate(), y});
+            } else {
+                add({Literal(-equal), x.negate(), y});
+            }
+            if (i + 1 == length) {
+                break;
+            }
+            const int next = formula.addVariable();
+            if (equal == 0) {
+                add({x.negate(), Literal(next)});
+                add({y, Literal(next)});
+            } else {
+                add({Literal(-equal), x.negate(), Literal(next)});
+                add({Literal(-equal), y, Literal(next)});
+            }
+            equal = next;
+        }
+    }
+    return added;
+}
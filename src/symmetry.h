@@ -0,0 +1,29 @@
+
+#ifndef SAT_SYMMETRY_H
+#define SAT_SYMMETRY_H
+
+#include "formula.h"
+#include <functional>
+#include <vector>
+
+namespace sat
+{
+    // image of each literal, indexed by Literal::index()
+    using Permutation = std::vector<int>;
+
+    // generators of symmetries of the formula, permutations of its literals
+    // that map its clauses onto themselves; found as automorphisms of the
+    // graph of literals and clauses by partition refinement and
+    // individualization, within a fixed amount of work so that the result
+    // is the same on every run unless stopped; possibly only some of the
+    // generators of the group
+    std::vector<Permutation> findSymmetries(const Formula& formula,
+            const std::function<bool()>& stopped);
+
+    // adds lex-leader clauses for each generator, the assignment over the
+    // variables in order is at most its image; these need fresh variables,
+    // returns the number of added clauses
+    int breakSymmetries(Formula& formula, const std::vector<Permutation>& generators);
+}
+
+#endif // SAT_SYMMETRY_H
@@ -0,0 +1,66 @@
+
+#include "totalizer.h"
+#include <algorithm>
+#include <stdexcept>
+
+sat::Totalizer::Totalizer(const std::vector<Literal>& inputs)
+{
+    if (inputs.empty()) {
+        throw std::invalid_argument("Totalizer without inputs");
+    }
+    nodes.reserve(2 * inputs.size() - 1);
+    root = build(inputs, 0, inputs.size());
+}
+
+// children are built before their parent
+int sat::Totalizer::build(const std::vector<Literal>& inputs, const int first, const int last)
+{
+    if (last - first == 1) {
+        nodes.push_back({-1, -1, 1, std::vector<Literal>(1, inputs[first])});
+    } else {
+        const int middle = first + (last - first) / 2;
+        const int left = build(inputs, first, middle);
+        const int right = build(inputs, middle, last);
+        nodes.push_back({left, right, last - first, std::vector<Literal>()});
+    }
+    return static_cast<int>(nodes.size()) - 1;
+}
+
+void sat::Totalizer::increase(const int bound, const std::function<int()>& newVariable,
+        std::vector<std::vector<Literal>>& clauses)
+{
+    increase(root, bound, newVariable, clauses);
+}
+
+// output s-1 is implied by i true inputs on the left and s-i on the right;
+// outputs below the old bound only need outputs of the children below it
+void sat::Totalizer::increase(const int node, const int bound,
+        const std::function<int()>& newVariable, std::vector<std::vector<Literal>>& clauses)
+{
+    const int size = std::min(bound, nodes[node].leaves);
+    if (static_cast<int>(nodes[node].outputs.size()) >= size) {
+        return;
+    }
+    const int left = nodes[node].left;
+    const int right = nodes[node].right;
+    increase(left, size, newVariable, clauses);
+    increase(right, size, newVariable, clauses);
+    const std::vector<Literal>& a = nodes[left].outputs;
+    const std::vector<Literal>& b = nodes[right].outputs;
+    const int numA = a.size();
+    const int numB = b.size();
+    for (int s = nodes[node].outputs.size() + 1; s <= size; s++) {
+        const Literal output(newVariable());
+        nodes[node].outputs.push_back(output);
+        for (int i = std::max(0, s - numB); i <= std::min(s, numA); i++) {
+            std::vector<Literal> clause(1, output);
+            if (i > 0) {
+                clause.push_back(a[i-1].negate());
+            }
+            if (s - i > 0) {
+                clause.push_back(b[s-i-1].negate());
+            }
+            clauses.push_back(std::move(clause));
+        }
+    }
+}
@@ -0,0 +1,44 @@
+
+#ifndef SAT_TOTALIZER_H
+#define SAT_TOTALIZER_H
+
+#include "literal.h"
+#include <functional>
+#include <vector>
+
+namespace sat
+{
+    // counts the true inputs in unary over a binary tree: output i is true
+    // if more than i inputs are true; clauses only force outputs up, enough
+    // to bound the count from above; outputs are added as bounds need them
+    class Totalizer
+    {
+    public:
+        explicit Totalizer(const std::vector<Literal>& inputs); // can throw
+        int numInputs() const { return nodes[root].leaves; }
+        int numOutputs() const { return static_cast<int>(nodes[root].outputs.size()); }
+        const Literal& output(const int i) const { return nodes[root].outputs.at(i); }
+        // adds outputs up to bound, with fresh variables from newVariable,
+        // appending the clauses defining them to clauses
+        void increase(const int bound, const std::function<int()>& newVariable,
+                std::vector<std::vector<Literal>>& clauses);
+
+    private:
+        struct Node
+        {
+            int left;
+            int right;
+            int leaves;
+            std::vector<Literal> outputs;
+        };
+
+        int build(const std::vector<Literal>& inputs, const int first, const int last);
+        void increase(const int node, const int bound, const std::function<int()>& newVariable,
+                std::vector<std::vector<Literal>>& clauses);
+
+        std::vector<Node> nodes;
+        int root;
+    };
+}
+
+#endif // SAT_TOTALIZER_H
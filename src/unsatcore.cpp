@@ -0,0 +1,127 @@
+
+#include "solver.h"
+#include <algorithm>
+#include <ostream>
+
+template <class Config>
+void sat::Solver<Config>::setCore(std::ostream& out, const bool minimize)
+{
+    coreOut = &out;
+    minimizeCore = minimize;
+}
+
+template <class Config>
+void sat::Solver<Config>::addSelectors()
+{
+    const int numClauses = formula.numClauses();
+    firstSelector = formula.numVariables() + 1;
+    for (int i = 0; i < numClauses; i++) {
+        newVariable();
+    }
+    inputClauses.reserve(numClauses);
+    std::vector<Literal> literals;
+    int selector = firstSelector;
+    for (Clause& clause: formula) {
+        inputClauses.emplace_back(clause.begin(), clause.end());
+        literals = inputClauses.back();
+        literals.push_back(Literal(-selector++));
+        clause = Clause(literals);
+    }
+}
+
+// searches under every selector; the selectors of a refutation are then
+// minimized by deletion: with one of them left out, a refutation gives a
+// smaller core, whose selectors the next checks are limited to, and a
+// model shows it is needed; learned clauses are kept between the checks,
+// since selectors make them hold whatever is assumed
+template <class Config>
+void sat::Solver<Config>::findCore()
+{
+    for (int v = firstSelector; v <= formula.numVariables(); v++) {
+        assumptions.push_back(Literal(v));
+    }
+    search();
+    backtrack(0);
+    assumptions.clear();
+    if (result != Result::Unsatisfiable) {
+        return;
+    }
+    if (core.empty()) {
+        // refuted without assumptions, by all the clauses then
+        for (int v = firstSelector; v <= formula.numVariables(); v++) {
+            core.push_back(Literal(v));
+        }
+    }
+    std::vector<Literal> needed;
+    std::vector<Literal> candidates(core);
+    while (minimizeCore && !candidates.empty() && !stopped()) {
+        const Literal candidate = candidates.back();
+        candidates.pop_back();
+        // the needed ones first, they are decided at every restart
+        assumptions = needed;
+        assumptions.insert(assumptions.end(), candidates.begin(), candidates.end());
+        result = Result::Unknown;
+        core.clear();
+        search();
+        backtrack(0);
+        if (result == Result::Unsatisfiable && !core.empty()) {
+            const std::unordered_set<Literal> refutation(core.begin(), core.end());
+            candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                        [&](const Literal& t) { return refutation.count(t) == 0; }),
+                    candidates.end());
+        } else if (result == Result::Satisfiable) {
+            needed.push_back(candidate);
+        } else {
+            candidates.push_back(candidate);
+            break;
+        }
+    }
+    assumptions.clear();
+    core = needed;
+    core.insert(core.end(), candidates.begin(), candidates.end());
+    result = Result::Unsatisfiable;
+    model.clear();
+    writeCore();
+}
+
+template <class Config>
+void sat::Solver<Config>::writeCore()
+{
+    std::vector<int> clauses;
+    for (const Literal& t: core) {
+        clauses.push_back(t.id() - firstSelector);
+    }
+    std::sort(clauses.begin(), clauses.end());
+    std::ostream& out = *coreOut;
+    out << "p cnf " << formula.numInputVariables() << " " << clauses.size() << "\n";
+    for (int c: clauses) {
+        for (const Literal& t: inputClauses[c]) {
+            out << t << " ";
+        }
+        out << "0\n";
+    }
+    out.flush();
+}
+
+namespace sat
+{
+    template void Solver<DefaultConfig<false, false>>::setCore(std::ostream&, const bool);
+    template void Solver<DefaultConfig<false, false>>::addSelectors();
+    template void Solver<DefaultConfig<false, false>>::findCore();
+    template void Solver<DefaultConfig<false, false>>::writeCore();
+
+    template void Solver<DefaultConfig<false, true>>::setCore(std::ostream&, const bool);
+    template void Solver<DefaultConfig<false, true>>::addSelectors();
+    template void Solver<DefaultConfig<false, true>>::findCore();
+    template void Solver<DefaultConfig<false, true>>::writeCore();
+
+    template void Solver<DefaultConfig<true, false>>::setCore(std::ostream&, const bool);
+    template void Solver<DefaultConfig<true, false>>::addSelectors();
+    template void Solver<DefaultConfig<true, false>>::findCore();
+    template void Solver<DefaultConfig<true, false>>::writeCore();
+
+    template void Solver<DefaultConfig<true, true>>::setCore(std::ostream&, const bool);
+    template void Solver<DefaultConfig<true, true>>::addSelectors();
+    template void Solver<DefaultConfig<true, true>>::findCore();
+    template void Solver<DefaultConfig<true, true>>::writeCore();
+}
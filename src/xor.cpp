@@ -0,0 +1,62 @@
+
+#include "xor.h"
+#include <algorithm>
+#include <utility>
+
+std::vector<sat::Xor> sat::findXors(const Formula& formula, const int maxSize)
+{
+    // a clause forbids the assignment where all its literals are false,
+    // the parity of that assignment is the parity of its negative literals;
+    // x1 + ... + xk = rhs forbids every assignment of parity !rhs
+    struct Pattern
+    {
+        std::vector<int> vars;
+        unsigned int negated;
+    };
+    std::vector<Pattern> patterns;
+    std::vector<std::pair<int, bool>> literals;
+    for (const Clause& clause: formula) {
+        const int k = clause.size();
+        if (k < 2 || k > maxSize) {
+            continue;
+        }
+        literals.clear();
+        for (const Literal& t: clause) {
+            literals.push_back({t.id(), t.polarity()});
+        }
+        std::sort(literals.begin(), literals.end());
+        Pattern p{std::vector<int>(), 0};
+        for (int i = 0; i < k; i++) {
+            p.vars.push_back(literals[i].first);
+            if (!literals[i].second) {
+                p.negated |= 1u << i;
+            }
+        }
+        patterns.push_back(std::move(p));
+    }
+    std::sort(patterns.begin(), patterns.end(), [](const Pattern& p1, const Pattern& p2) {
+        return p1.vars != p2.vars ? p1.vars < p2.vars : p1.negated < p2.negated;
+    });
+
+    std::vector<Xor> xors;
+    std::size_t i = 0;
+    while (i < patterns.size()) {
+        std::size_t j = i;
+        // distinct sign patterns of each parity over the same variables
+        std::size_t count[2] = {0, 0};
+        while (j < patterns.size() && patterns[j].vars == patterns[i].vars) {
+            if (j == i || patterns[j].negated != patterns[j-1].negated) {
+                count[__builtin_popcount(patterns[j].negated) & 1]++;
+            }
+            j++;
+        }
+        const std::size_t needed = std::size_t(1) << (patterns[i].vars.size() - 1);
+        for (int parity = 0; parity < 2; parity++) {
+            if (count[parity] == needed) {
+                xors.push_back({patterns[i].vars, parity == 0});
+            }
+        }
+        i = j;
+    }
+    return xors;
+}
@@ -0,0 +1,22 @@
+
+#ifndef SAT_XOR_H
+#define SAT_XOR_H
+
+#include "formula.h"
+#include <vector>
+
+namespace sat
+{
+    // x1 + x2 + ... + xk = rhs (mod 2)
+    struct Xor
+    {
+        std::vector<int> vars;
+        bool rhs;
+    };
+
+    // recovers the xor constraints whose full CNF encoding, the 2^(k-1)
+    // clauses over the same k variables, is in the formula
+    std::vector<Xor> findXors(const Formula& formula, const int maxSize);
+}
+
+#endif // SAT_XOR_H